@@ -5,24 +5,54 @@
 #ifndef AVL_TREE_H
 #define AVL_TREE_H
 //#include <iostream>
-#include <stack>
 #include <queue>
 #include <limits>
+#include "Node_Pool.h"
+#include "Order_Statistics.h"
+#include "Path_Buffer.h"
 
-template<typename Key, typename Value>
+// ORDER_STATISTICS keeps subtree sizes in every node for O(log N) rank, select and range_count,
+// Node_Allocator builds and frees the nodes (see Node_Pool.h)
+template<typename Key, typename Value, bool ORDER_STATISTICS = false, template<typename> class Node_Allocator = Node_Pool>
 class AVL_Tree{
     public:
-        struct Node{
+        struct Node : Subtree_Size<ORDER_STATISTICS> {
             std::pair<Key,Value> data;
             Node* left;
             Node* right;
+            Node* parent;
             size_t height;
             int balance_factor;
-            Node() : left(nullptr), right(nullptr), height(0), balance_factor(0){}
+            Node() : left(nullptr), right(nullptr), parent(nullptr), height(0), balance_factor(0){}
         };
     private:
         Node* root;
+        // Cached smallest and largest nodes, so begin() and --end() need no descent
+        Node* leftmost;
+        Node* rightmost;
         size_t node_count;
+        Node_Allocator<Node> node_allocator;
+        using Order_Statistics_Tag = std::integral_constant<bool, ORDER_STATISTICS>;
+
+        static void set_parent(Node* child, Node* parent) {
+            if (child != nullptr) {
+                child->parent = parent;
+            }
+        }
+
+        // An extreme only changes when erase frees its cached node, and then both are found again from the root
+        void drop_extreme(Node* node) {
+            if (node == this->leftmost) this->leftmost = nullptr;
+            if (node == this->rightmost) this->rightmost = nullptr;
+        }
+
+        void refresh_extremes() {
+            this->leftmost = this->root;
+            this->rightmost = this->root;
+            if (this->root == nullptr) return;
+            while (this->leftmost->left != nullptr) this->leftmost = this->leftmost->left;
+            while (this->rightmost->right != nullptr) this->rightmost = this->rightmost->right;
+        }
 
         void update_H_and_BF(Node* back_node) {
             int left_height = -1;
@@ -35,11 +65,12 @@ class AVL_Tree{
             }
             back_node->height = 1 + std::max(left_height,right_height);
             back_node->balance_factor = left_height - right_height;
+            update_subtree_size(back_node, Order_Statistics_Tag{});
         }
-        void balance_tree(std::stack<Node*>& node_storage, bool deletion = false) {
+        void balance_tree(Path_Buffer<Node*>& node_storage, bool deletion = false) {
             while(!node_storage.empty()) {
-                Node* nav_node = node_storage.top();
-                node_storage.pop();
+                Node* nav_node = node_storage.back();
+                node_storage.pop_back();
                 update_H_and_BF(nav_node);
                 Node* new_subtree_root = nav_node;
 
@@ -66,18 +97,22 @@ class AVL_Tree{
                     this->root = new_subtree_root;
                     continue;
                 }
-                if(node_storage.top()->left == nav_node) {
-                    node_storage.top()->left = new_subtree_root;
+                if(node_storage.back()->left == nav_node) {
+                    node_storage.back()->left = new_subtree_root;
                 }
                 else {
-                    node_storage.top()->right = new_subtree_root;
+                    node_storage.back()->right = new_subtree_root;
                 }
 
-                //check if done
+                //check if done, the ancestors' heights are settled but their sizes still grow by one
                 if (new_subtree_root != nav_node and deletion == false) {
                     break;
                 }
             }
+            while (ORDER_STATISTICS and !node_storage.empty()) {
+                update_subtree_size(node_storage.back(), Order_Statistics_Tag{});
+                node_storage.pop_back();
+            }
         }
 
         Node* rotateLeft(Node* grandparent){
@@ -92,6 +127,9 @@ class AVL_Tree{
             Node* temp_left = parent->left;
             parent->left = grandparent;
             grandparent->right = temp_left;
+            parent->parent = grandparent->parent;
+            grandparent->parent = parent;
+            set_parent(temp_left, grandparent);
             update_H_and_BF(grandparent);
             update_H_and_BF(parent);
             return parent;
@@ -109,6 +147,9 @@ class AVL_Tree{
             Node* temp_right = parent->right;
             parent->right = grandparent;
             grandparent->left = temp_right;
+            parent->parent = grandparent->parent;
+            grandparent->parent = parent;
+            set_parent(temp_right, grandparent);
             update_H_and_BF(grandparent);
             update_H_and_BF(parent);
             return parent;
@@ -133,6 +174,11 @@ class AVL_Tree{
             //break cycles
             parent -> left = temp_right;
             grandparent -> right = temp_left;
+            child->parent = grandparent->parent;
+            grandparent->parent = child;
+            parent->parent = child;
+            set_parent(temp_left, grandparent);
+            set_parent(temp_right, parent);
             update_H_and_BF(grandparent);
             update_H_and_BF(parent);
             update_H_and_BF(child);
@@ -158,16 +204,22 @@ class AVL_Tree{
             //break cycles
             parent -> right = temp_left;
             grandparent -> left = temp_right;
+            child->parent = grandparent->parent;
+            grandparent->parent = child;
+            parent->parent = child;
+            set_parent(temp_left, parent);
+            set_parent(temp_right, grandparent);
             update_H_and_BF(grandparent);
             update_H_and_BF(parent);
             update_H_and_BF(child);
             return child;
         }
 
-        Node* successor(Node* nav_node){
+        // Parent links make a full scan O(N): every edge is climbed or descended at most twice
+        static Node* successor(Node* nav_node){
             // Case 1: If node has a right subtree,
             // the successor is the leftmost node in the right subtree.
-            if(nav_node != nullptr && nav_node->right != nullptr){
+            if(nav_node->right != nullptr){
                 Node* succ = nav_node->right;
                 while(succ->left != nullptr){
                     succ = succ->left;
@@ -178,30 +230,16 @@ class AVL_Tree{
             // Case 2: If node has no right subtree,
             // the successor is the lowest ancestor for which
             // the navigation node is in its left subtree.
-            // We go back to the root instead of continuing
-            // at the navigation node.
-            Node* succ = nullptr;
-            Node* nav_node2 = this->root;
-            while (nav_node2 != nullptr) {
-                if (nav_node->data.first < nav_node2->data.first) {
-                    succ = nav_node2;
-                    nav_node2 = nav_node2->left;
-                }
-                else if (nav_node->data.first > nav_node2->data.first) {
-                    nav_node2 = nav_node2->right;
-                }
-                else {
-                    // Arrived at the original node
-                    break;
-                }
+            while (nav_node->parent != nullptr and nav_node->parent->right == nav_node) {
+                nav_node = nav_node->parent;
             }
-            return succ;
+            return nav_node->parent;
         }
 
-        Node* predecessor(Node* nav_node){
+        static Node* predecessor(Node* nav_node){
             // Case 1: If node has a left subtree,
-            // the successor is the rightmost node in the left subtree.
-            if(nav_node != nullptr && nav_node->left != nullptr){
+            // the predecessor is the rightmost node in the left subtree.
+            if(nav_node->left != nullptr){
                 Node* pred = nav_node->left;
                 while(pred->right != nullptr){
                     pred = pred->right;
@@ -212,24 +250,47 @@ class AVL_Tree{
             // Case 2: If node has no left subtree,
             // the predecessor is the lowest ancestor for which
             // the navigation node is in its right subtree.
-            // We go back to the root instead of continuing
-            // at the navigation node.
-            Node* pred = nullptr;
-            Node* nav_node2 = this->root;
-            while (nav_node2 != nullptr) {
-                if (nav_node->data.first > nav_node2->data.first) {
-                    pred = nav_node2;
-                    nav_node2 = nav_node2->right;
-                }
-                else if (nav_node->data.first < nav_node2->data.first) {
-                    nav_node2 = nav_node2->left;
-                }
-                else {
-                    // Arrived at the original node
-                    break;
+            while (nav_node->parent != nullptr and nav_node->parent->left == nav_node) {
+                nav_node = nav_node->parent;
+            }
+            return nav_node->parent;
+        }
+
+        // In-order walk of [lo, hi]: subtrees wholly below lo are never entered and the walk stops
+        // at the first key past hi, so it costs O(log N + K) without the per-step root descents of ++
+        template<typename Visit>
+        void range_walk(const Key& lo, const Key& hi, Visit visit) const {
+            Path_Buffer<Node*> node_storage;
+            Node* nav_node = this->root;
+            while (nav_node != nullptr or !node_storage.empty()) {
+                while (nav_node != nullptr) {
+                    if (nav_node->data.first < lo) {
+                        nav_node = nav_node->right;
+                    }
+                    else {
+                        node_storage.push_back(nav_node);
+                        nav_node = nav_node->left;
+                    }
                 }
+                if (node_storage.empty()) return;
+                nav_node = node_storage.back();
+                node_storage.pop_back();
+                if (hi < nav_node->data.first) return;
+                visit(nav_node);
+                nav_node = nav_node->right;
             }
-            return pred;
+        }
+
+        // Two rank descents with the augmentation, a range walk without it
+        size_t range_count(const Key& lo, const Key& hi, std::true_type) const {
+            if (hi < lo) return 0;
+            return subtree_rank<true>(this->root, hi) - subtree_rank<false>(this->root, lo);
+        }
+
+        size_t range_count(const Key& lo, const Key& hi, std::false_type) const {
+            size_t count = 0;
+            range_walk(lo, hi, [&count](const Node*) { ++count; });
+            return count;
         }
 
     public:
@@ -292,11 +353,7 @@ class AVL_Tree{
             // Pre-decrement (--it)
             iterator& operator--() {
                 if (node_ptr == nullptr) {
-                    Node* max_node = AVL_Tree_ptr->root;
-                    if (max_node != nullptr) {
-                        while (max_node->right != nullptr) max_node = max_node->right;
-                    }
-                    node_ptr = max_node;
+                    node_ptr = AVL_Tree_ptr->rightmost;
                 } else {
                     node_ptr = AVL_Tree_ptr->predecessor(node_ptr);
                 }
@@ -388,11 +445,7 @@ class AVL_Tree{
             // Pre-decrement (--it)
             const_iterator& operator--() {
                 if (node_ptr == nullptr) {
-                    Node* max_node = AVL_Tree_ptr->root;
-                    if (max_node != nullptr) {
-                        while (max_node->right != nullptr) max_node = max_node->right;
-                    }
-                    node_ptr = max_node;
+                    node_ptr = AVL_Tree_ptr->rightmost;
                 } else {
                     node_ptr = AVL_Tree_ptr->predecessor(node_ptr);
                 }
@@ -425,7 +478,7 @@ class AVL_Tree{
             }
         };
     
-        AVL_Tree() : root(nullptr), node_count(0){}
+        AVL_Tree() : root(nullptr), leftmost(nullptr), rightmost(nullptr), node_count(0){}
 
         ~AVL_Tree(){
             this->clear();
@@ -435,20 +488,26 @@ class AVL_Tree{
             if (this->root == nullptr) {
                 return;
             }
-            std::queue<Node*> q;
-            q.push(this->root);
-            while(!q.empty()){
-                Node* nav_node = q.front();
-                q.pop();
-                if(nav_node->left != nullptr){
-                    q.push(nav_node->left);
-                }
-                if(nav_node->right != nullptr){
-                    q.push(nav_node->right);
+            // Trivially destructible nodes go back with their slabs, no walk needed
+            if (!Node_Allocator<Node>::BULK_RELEASE) {
+                std::queue<Node*> q;
+                q.push(this->root);
+                while(!q.empty()){
+                    Node* nav_node = q.front();
+                    q.pop();
+                    if(nav_node->left != nullptr){
+                        q.push(nav_node->left);
+                    }
+                    if(nav_node->right != nullptr){
+                        q.push(nav_node->right);
+                    }
+                    node_allocator.destroy(nav_node);
                 }
-                delete nav_node;
             }
+            node_allocator.release();
             this->root = nullptr;
+            this->leftmost = nullptr;
+            this->rightmost = nullptr;
             this->node_count = 0;
         }
 
@@ -472,20 +531,22 @@ class AVL_Tree{
         }
 
         bool insert(const Key& key, const Value& value){
-            Node* new_node = new Node();
+            Node* new_node = node_allocator.create();
             new_node->data.first = key;
             new_node->data.second = value;
-            std::stack<Node*> node_storage;
+            Path_Buffer<Node*> node_storage;
             if(this->root == nullptr){
                 this->root = new_node;
                 this->root->height = 0;
+                this->leftmost = new_node;
+                this->rightmost = new_node;
                 ++this->node_count;
                 return true;
             }
             Node* nav_node = this->root;
             Node* follower_node = nullptr;
             while(true){
-                node_storage.push(nav_node);
+                node_storage.push_back(nav_node);
                 if(key > nav_node->data.first){
                     follower_node = nav_node;
                     nav_node = nav_node->right;
@@ -503,10 +564,13 @@ class AVL_Tree{
                     }
                 }
                 else{
-                    delete new_node;
+                    node_allocator.destroy(new_node);
                     return false;
                 }
             }
+            new_node->parent = follower_node;
+            if (follower_node == this->leftmost and follower_node->left == new_node) this->leftmost = new_node;
+            if (follower_node == this->rightmost and follower_node->right == new_node) this->rightmost = new_node;
             balance_tree(node_storage);
             ++this->node_count;
             return true;
@@ -517,29 +581,32 @@ class AVL_Tree{
                 return false;
             }
 
-            std::stack<Node*> node_storage;
+            Path_Buffer<Node*> node_storage;
 
             // Root case
             if(this->root->data.first == key){
                 if (this->root->left == nullptr && this->root->right == nullptr) { // Leaf node
-                    delete this->root;
+                    drop_extreme(this->root);
+                    node_allocator.destroy(this->root);
                     this->root = nullptr;
                 }
                 else if(this->root->left != nullptr && this->root->right != nullptr){ // Has two children
-                    node_storage.push(this->root);
+                    node_storage.push_back(this->root);
                     Node* successor = this->root->right;
                     while (successor->left != nullptr) {
-                        node_storage.push(successor);
+                        node_storage.push_back(successor);
                         successor = successor->left;
                     }
                     this->root->data = successor->data;
-                    if(node_storage.top() == this->root) {
-                        node_storage.top()->right = successor->right;
+                    if(node_storage.back() == this->root) {
+                        node_storage.back()->right = successor->right;
                     }
                     else {
-                        node_storage.top()->left = successor->right;
+                        node_storage.back()->left = successor->right;
                     }
-                    delete successor;
+                    set_parent(successor->right, node_storage.back());
+                    drop_extreme(successor);
+                    node_allocator.destroy(successor);
                     balance_tree(node_storage, true);
                 }
                 else { // Has one child
@@ -550,9 +617,13 @@ class AVL_Tree{
                     } else {
                         this->root = this->root->right;
                     }
+                    this->root->parent = nullptr;
+
+                    drop_extreme(old_root);
 
-                    delete old_root;
+                    node_allocator.destroy(old_root);
                 }
+                if (this->leftmost == nullptr or this->rightmost == nullptr) refresh_extremes();
                 --this->node_count;
                 return true; // <-- BUG FIX
             }
@@ -560,7 +631,7 @@ class AVL_Tree{
             // Non-root case
             Node* nav_node = this->root;
             while(nav_node != nullptr) {
-                node_storage.push(nav_node);
+                node_storage.push_back(nav_node);
                 if(key < nav_node->data.first) {
                     nav_node = nav_node->left;
                 }
@@ -568,24 +639,25 @@ class AVL_Tree{
                     nav_node = nav_node->right;
                 }
                 else { // Found the node to delete
-                    node_storage.pop();
+                    node_storage.pop_back();
 
                     if(nav_node->left == nullptr && nav_node->right == nullptr) { // Leaf node
-                        if(node_storage.top()->left == nav_node) {
-                            node_storage.top()->left = nullptr;
+                        if(node_storage.back()->left == nav_node) {
+                            node_storage.back()->left = nullptr;
                         }
                         else {
-                            node_storage.top()->right = nullptr;
+                            node_storage.back()->right = nullptr;
                         }
-                        delete nav_node;
+                        drop_extreme(nav_node);
+                        node_allocator.destroy(nav_node);
                     }
                     else if(nav_node->left != nullptr && nav_node->right != nullptr){ // Has two children
-                        node_storage.push(nav_node);
+                        node_storage.push_back(nav_node);
                         Node* successor_parent = nav_node;
                         Node* successor = nav_node->right;
                         while (successor->left != nullptr) {
                             successor_parent = successor;
-                            node_storage.push(successor);
+                            node_storage.push_back(successor);
                             successor = successor->left;
                         }
                         nav_node->data = successor->data;
@@ -597,7 +669,9 @@ class AVL_Tree{
                         else {
                             successor_parent->left = successor->right;
                         }
-                        delete successor;
+                        set_parent(successor->right, successor_parent);
+                        drop_extreme(successor);
+                        node_allocator.destroy(successor);
                     }
                     else { // Has one child
 
@@ -608,16 +682,19 @@ class AVL_Tree{
                             child = nav_node->right;
                         }
 
-                        if(node_storage.top()->left == nav_node) {
-                            node_storage.top()->left = child;
+                        if(node_storage.back()->left == nav_node) {
+                            node_storage.back()->left = child;
                         }
                         else {
-                            node_storage.top()->right = child;
+                            node_storage.back()->right = child;
                         }
-                        delete nav_node;
+                        child->parent = node_storage.back();
+                        drop_extreme(nav_node);
+                        node_allocator.destroy(nav_node);
                     }
 
                     balance_tree(node_storage, true);
+                    if (this->leftmost == nullptr or this->rightmost == nullptr) refresh_extremes();
                     --this->node_count;
                     return true;
                 }
@@ -731,15 +808,46 @@ class AVL_Tree{
             return const_iterator(this, potential_succ);
         }
 
+        // Inclusive [lo, hi], f(key, value) in ascending key order
+        template<typename Function>
+        void range_for_each(const Key& lo, const Key& hi, Function f) {
+            range_walk(lo, hi, [&f](Node* node) { f(node->data.first, node->data.second); });
+        }
+
+        template<typename Function>
+        void range_for_each(const Key& lo, const Key& hi, Function f) const {
+            range_walk(lo, hi, [&f](const Node* node) { f(node->data.first, node->data.second); });
+        }
+
+        size_t range_count(const Key& lo, const Key& hi) const {
+            return range_count(lo, hi, Order_Statistics_Tag{});
+        }
+
+        Value range_sum(const Key& lo, const Key& hi) const {
+            Value sum{};
+            range_walk(lo, hi, [&sum](const Node* node) { sum += node->data.second; });
+            return sum;
+        }
+
+        // Number of keys below key, O(log N)
+        size_t rank(const Key& key) const {
+            static_assert(ORDER_STATISTICS, "rank needs AVL_Tree<Key, Value, true>");
+            return subtree_rank<false>(this->root, key);
+        }
+
+        // The k-th smallest entry (0-based), end() when k >= size()
+        iterator select(size_t k) {
+            static_assert(ORDER_STATISTICS, "select needs AVL_Tree<Key, Value, true>");
+            return iterator(this, subtree_select(this->root, k));
+        }
+
+        const_iterator select(size_t k) const {
+            static_assert(ORDER_STATISTICS, "select needs AVL_Tree<Key, Value, true>");
+            return const_iterator(this, subtree_select(this->root, k));
+        }
+
         iterator begin() {
-            // Find the minimum node (go left as far as possible)
-            Node* min_node = root;
-            if (min_node != nullptr) {
-                while (min_node->left != nullptr) {
-                    min_node = min_node->left;
-                }
-            }
-            return iterator(this, min_node);
+            return iterator(this, this->leftmost);
         }
 
         iterator end() {
@@ -747,13 +855,7 @@ class AVL_Tree{
         }
 
         const_iterator begin() const {
-            Node* min_node = root;
-            if (min_node != nullptr) {
-                while (min_node->left != nullptr) {
-                    min_node = min_node->left;
-                }
-            }
-            return const_iterator(this, min_node);
+            return const_iterator(this, this->leftmost);
         }
 
         const_iterator end() const {
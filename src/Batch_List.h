@@ -6,83 +6,351 @@
 #define BATCH_LIST_H
 #include <algorithm>
 //#include <limits>
+#include <stdexcept>
 #include <utility>
 #include <vector>
 #include "Doubly_Linked_List.h"
 #include "Radix_Sort.h"
-template<typename Key, typename Value>
+
+// Nodes between two express-lane entries, so point lookups walk at most this far after a binary search
+const size_t BATCH_LIST_EXPRESS_STRIDE = 32;
+
+// EXPRESS_STRIDE = 0 turns the express lane off and point lookups walk from the head
+template<typename Key, typename Value, size_t EXPRESS_STRIDE = BATCH_LIST_EXPRESS_STRIDE>
 class Batch_List : public Doubly_Linked_List<std::pair<Key, Value>>{
     public:
         using Pair = std::pair<Key, Value>;
         using DLL = Doubly_Linked_List<Pair>;
         using list_iter = typename DLL::iterator;
     private:
-        void sort_keys(){
-            radix_sort(*this, [](const Pair& p) { return p.first; });
+        using Node = typename DLL::Node;
+
+        // Inserts append at the tail: the last unsorted_count nodes are unsorted, everything before them is sorted
+        size_t unsorted_count = 0;
+
+        // Every EXPRESS_STRIDE-th node of the sorted list with its key, rebuilt by the first lookup after a merge
+        std::vector<std::pair<Key, Node*>> express_lane;
+        bool express_lane_valid = false;
+
+        void build_express_lane() {
+            express_lane.clear();
+            size_t pos = 0;
+            for (Node* node = this->head; node != nullptr; node = node->next, ++pos) {
+                if (pos % EXPRESS_STRIDE == 0) {
+                    express_lane.emplace_back(node->value.first, node);
+                }
+            }
+            express_lane_valid = true;
+        }
+
+        // First node with key >= key (OR_EQUAL: > key), nullptr if none. A binary search over the lane picks
+        // the last entry before the answer, then the walk covers at most one stride: O(log N + EXPRESS_STRIDE)
+        template<bool OR_EQUAL>
+        Node* bound_node(const Key& key) {
+            this->sort_keys();
+            Node* node = this->head;
+            if (EXPRESS_STRIDE != 0) {
+                if (!express_lane_valid) build_express_lane();
+                auto lane_iter = express_lane.begin();
+                if (OR_EQUAL) {
+                    lane_iter = std::upper_bound(express_lane.begin(), express_lane.end(), key,
+                        [](const Key& k, const std::pair<Key, Node*>& entry) { return k < entry.first; });
+                }
+                else {
+                    lane_iter = std::lower_bound(express_lane.begin(), express_lane.end(), key,
+                        [](const std::pair<Key, Node*>& entry, const Key& k) { return entry.first < k; });
+                }
+                if (lane_iter != express_lane.begin()) {
+                    node = std::prev(lane_iter)->second;
+                }
+            }
+            while (node != nullptr and (node->value.first < key or (OR_EQUAL and not (key < node->value.first)))) {
+                node = node->next;
+            }
+            return node;
+        }
+
+        // Lane entries for an erased run of key move to the node after it, or are dropped
+        void unlink_express_lane(const Key& key, Node* next_node) {
+            if (!express_lane_valid) return;
+            auto first = std::lower_bound(express_lane.begin(), express_lane.end(), key,
+                [](const std::pair<Key, Node*>& entry, const Key& k) { return entry.first < k; });
+            auto last = first;
+            while (last != express_lane.end() and last->first == key) {
+                ++last;
+            }
+            if (first == last) return;
+            if (next_node != nullptr and (last == express_lane.end() or last->second != next_node)) {
+                *first = std::make_pair(next_node->value.first, next_node);
+                ++first;
+            }
+            express_lane.erase(first, last);
         }
+
+        // A lane entry for a single node moves to the node after it, or is dropped; call before destroying it
+        void unlink_express_node(Node* node) {
+            if (!express_lane_valid) return;
+            auto entry = std::lower_bound(express_lane.begin(), express_lane.end(), node->value.first,
+                [](const std::pair<Key, Node*>& lane_entry, const Key& k) { return lane_entry.first < k; });
+            while (entry != express_lane.end() and entry->second != node and entry->first == node->value.first) {
+                ++entry;
+            }
+            if (entry == express_lane.end() or entry->second != node) return;
+            Node* next_node = node->next;
+            if (next_node != nullptr and (std::next(entry) == express_lane.end() or std::next(entry)->second != next_node)) {
+                *entry = std::make_pair(next_node->value.first, next_node);
+            }
+            else {
+                express_lane.erase(entry);
+            }
+        }
+
+        // Links a new node in front of next_node, at the tail when next_node is nullptr
+        void link_before(Node* next_node, const Pair& pair) {
+            if (next_node == nullptr) {
+                DLL::addTail(pair);
+                return;
+            }
+            Node* new_node = this->node_allocator.create(pair);
+            new_node->next = next_node;
+            new_node->prev = next_node->prev;
+            if (next_node->prev != nullptr) {
+                next_node->prev->next = new_node;
+            }
+            else {
+                this->head = new_node;
+            }
+            next_node->prev = new_node;
+            ++this->node_count;
+        }
+
     public:
+        // Sorts only the unsorted tail and merges it backward into the sorted prefix, so the cost is
+        // O(new) plus the sorted nodes it passes; a clean list returns immediately.
+        // Call it before iterating through a const reference, const reads never merge
+        void sort_keys(){
+            if (unsorted_count == 0) return;
+
+            std::vector<Node*> new_nodes(unsorted_count);
+            Node* prefix_tail = this->tail;
+            for (size_t i = unsorted_count; i > 0; --i) {
+                new_nodes[i - 1] = prefix_tail;
+                prefix_tail = prefix_tail->prev;
+            }
+            unsorted_count = 0;
+            express_lane_valid = false;
+            radix_sort(new_nodes.begin(), new_nodes.end(), [](const Node* node) { return node->value.first; });
+
+            // Build the merged run from the back, equal keys keep the older node first
+            Node* merged_head = nullptr;
+            size_t new_pos = new_nodes.size();
+            while (new_pos > 0) {
+                Node* node;
+                if (prefix_tail != nullptr and new_nodes[new_pos - 1]->value.first < prefix_tail->value.first) {
+                    node = prefix_tail;
+                    prefix_tail = prefix_tail->prev;
+                }
+                else {
+                    node = new_nodes[--new_pos];
+                }
+                node->next = merged_head;
+                if (merged_head != nullptr) {
+                    merged_head->prev = node;
+                }
+                else {
+                    this->tail = node;
+                }
+                merged_head = node;
+            }
+
+            // The untouched prefix [head, prefix_tail] is still linked
+            merged_head->prev = prefix_tail;
+            if (prefix_tail != nullptr) {
+                prefix_tail->next = merged_head;
+            }
+            else {
+                this->head = merged_head;
+            }
+        }
+
         Batch_List() : DLL() {}
 
-        void insert(const std::pair<Key, Value>& map_pair) {
-            this->addHead(map_pair);
+        // The express lane points into the source list's nodes, so copies rebuild their own.
+        // Copies merge the pending inserts they take over, so a const list never has any to sort
+        Batch_List(const Batch_List& other) : DLL(other), unsorted_count(other.unsorted_count) {
             this->sort_keys();
         }
 
+        Batch_List& operator=(const Batch_List& other) {
+            if (this != &other) {
+                DLL::operator=(other);
+                unsorted_count = other.unsorted_count;
+                express_lane_valid = false;
+                this->sort_keys();
+            }
+            return *this;
+        }
+
+        // O(1): the node joins the unsorted tail until a read needs the order
+        void insert(const std::pair<Key, Value>& map_pair) {
+            DLL::addTail(map_pair);
+            ++unsorted_count;
+        }
+
         void insert(const Key& key, const Value& value) {
-            this->addHead({key, value});
+            DLL::addTail({key, value});
+            ++unsorted_count;
+        }
+
+        // Iteration sees sorted order, pending inserts are merged first
+        list_iter begin() {
             this->sort_keys();
+            return DLL::begin();
         }
 
-        list_iter find(const Key& key){
-            for(auto iter = this->begin(); iter != this->end(); ++iter){
-                if(key == iter->first){
-                    return iter;
-                }
+        // Read-only: throws while inserts are pending instead of merging them, so const reads never write
+        typename DLL::const_iterator begin() const {
+            if (unsorted_count != 0) {
+                throw std::logic_error("Batch_List has unsorted inserts, call sort_keys() first!");
             }
-            return this->end();
+            return DLL::begin();
         }
 
-        list_iter predecessor(const Key& key) {
+        typename DLL::const_iterator cbegin() const {
+            return this->begin();
+        }
+
+        void clear() {
+            DLL::clear();
+            unsorted_count = 0;
+            express_lane.clear();
+            express_lane_valid = false;
+        }
+
+        /*
+            The Doubly_Linked_List mutators are shadowed so the unsorted tail stays counted. A position means
+            nothing in a sorted list, so addHead, addTail and insertAt add the pair like insert; removals merge
+            pending inserts first, so head, tail and indices refer to sorted order. Every removal patches or
+            drops the express lane, which must never point at a destroyed node.
+        */
+        void addHead(const Pair& pair) {
+            this->insert(pair);
+        }
+
+        void addTail(const Pair& pair) {
+            this->insert(pair);
+        }
+
+        void insertAt(const Pair& pair, size_t index) {
+            if (index > this->size()) {
+                throw std::out_of_range("Index out of range!");
+            }
+            this->insert(pair);
+        }
+
+        bool removeHead() {
             this->sort_keys();
-            list_iter curr_node = this->begin();
-            list_iter prev_node = this->end();
-            while (curr_node != this->end()) {
-                if (curr_node->first >= key) {
-                    return prev_node;
-                }
-                prev_node = curr_node;
-                ++curr_node;
+            if (this->head == nullptr) return false;
+            this->erase(DLL::node_iterator(this->head));
+            return true;
+        }
+
+        bool removeTail() {
+            this->sort_keys();
+            if (this->tail == nullptr) return false;
+            this->erase(DLL::node_iterator(this->tail));
+            return true;
+        }
+
+        // Positional and by-value removals are rare, they drop the lane instead of searching it
+        bool removeAt(size_t index) {
+            this->sort_keys();
+            express_lane_valid = false;
+            return DLL::removeAt(index);
+        }
+
+        bool remove(const Pair& pair) {
+            this->sort_keys();
+            express_lane_valid = false;
+            return DLL::remove(pair);
+        }
+
+        int removeNodesWithValue(const Pair& pair) {
+            this->sort_keys();
+            express_lane_valid = false;
+            return DLL::removeNodesWithValue(pair);
+        }
+
+        // Sorting relinks nodes without moving them, so pos stays valid; the returned iterator is its sorted successor
+        list_iter erase(list_iter pos) {
+            this->sort_keys();
+            if (pos != this->end()) {
+                unlink_express_node(DLL::iterator_node(pos));
             }
-            return prev_node;
+            return DLL::erase(pos);
         }
 
-        list_iter successor(const Key& key) {
+        Pair& operator[](size_t index) {
             this->sort_keys();
-            list_iter curr_node = this->begin();
-            while (curr_node != this->end()) {
-                if (curr_node->first > key) {
-                    return curr_node;
-                }
-                ++curr_node;
+            return DLL::operator[](index);
+        }
+
+        // Point lookups go through the express lane, O(log N + EXPRESS_STRIDE) on a sorted list
+        list_iter find(const Key& key){
+            Node* node = bound_node<false>(key);
+            if (node != nullptr and node->value.first == key) {
+                return DLL::node_iterator(node);
             }
             return this->end();
         }
 
+        list_iter predecessor(const Key& key) {
+            Node* node = bound_node<false>(key);
+            return DLL::node_iterator(node == nullptr ? this->tail : node->prev);
+        }
+
+        list_iter successor(const Key& key) {
+            return DLL::node_iterator(bound_node<true>(key));
+        }
+
+        // Erases every node with key; the next node is taken before each erase so the walk never touches a freed node
         void erase_key(const Key& key){
-            for(auto iter = this->begin(); iter != this->end(); ++iter){
-                if(iter->first == key){
-                    this->erase(iter);
-                }
+            Node* node = bound_node<false>(key);
+            while (node != nullptr and node->value.first == key) {
+                Node* next_node = node->next;
+                DLL::erase(DLL::node_iterator(node));
+                node = next_node;
             }
+            unlink_express_lane(key, node);
         }
 
+        /*
+            Merge join: the batch is radix sorted on its own and spliced into the sorted list in one forward
+            pass, so the cost is sorting B plus one walk up to the largest batch key instead of re-sorting
+            the list. Keys the list already holds keep their value and repeats inside the batch keep their
+            first occurrence, so batch_find sees one node per key.
+        */
         template<typename InputIter>
         void batch_insert(InputIter begin, InputIter end) {
-            while(begin != end){
-                this->addHead(*begin);
-                ++begin;
-            }
+            std::vector<Pair> batch(begin, end);
+            if (batch.empty()) return;
+
+            radix_sort(batch.begin(), batch.end(), [](const Pair& pair) { return pair.first; });
+            auto last = std::unique(batch.begin(), batch.end(),
+                [](const Pair& a, const Pair& b) { return a.first == b.first; });
+            batch.erase(last, batch.end());
+
+            // A current express lane finds the start; a stale one is not worth rebuilding for a single pass
             this->sort_keys();
+            Node* node = express_lane_valid ? bound_node<false>(batch.front().first) : this->head;
+            for (const Pair& pair : batch) {
+                while (node != nullptr and node->value.first < pair.first) {
+                    node = node->next;
+                }
+                if (node != nullptr and node->value.first == pair.first) continue;
+                link_before(node, pair);
+            }
+            express_lane_valid = false;
         }
 
         void batch_insert(const std::vector<Key>& keys) {
@@ -150,12 +418,36 @@ class Batch_List : public Doubly_Linked_List<std::pair<Key, Value>>{
             return results;
         }
 
+        // Inclusive [lo, hi]: jump to lo through the express lane, then visit until a key passes hi
+        template<typename Function>
+        void range_for_each(const Key& lo, const Key& hi, Function f) {
+            list_iter curr_node = DLL::node_iterator(bound_node<false>(lo));
+            while (curr_node != this->end() and curr_node->first <= hi) {
+                f(curr_node->first, curr_node->second);
+                ++curr_node;
+            }
+        }
+
+        size_t range_count(const Key& lo, const Key& hi) {
+            size_t count = 0;
+            range_for_each(lo, hi, [&count](const Key&, const Value&) { ++count; });
+            return count;
+        }
+
+        Value range_sum(const Key& lo, const Key& hi) {
+            Value sum{};
+            range_for_each(lo, hi, [&sum](const Key&, const Value& value) { sum += value; });
+            return sum;
+        }
+
+        // Erases one node per listed key (the oldest of a repeated key), erase_key removes the whole run
         template<typename InputIter>
         void batch_erase(InputIter begin, InputIter end) {
             std::vector<Key> keys2erase(begin, end);
             if (keys2erase.empty()) return;
 
             this->sort_keys();
+            express_lane_valid = false;
             radix_sort(keys2erase.begin(), keys2erase.end(), [](const Key& key) { return key; });
 
             // Remove duplicates
@@ -171,7 +463,7 @@ class Batch_List : public Doubly_Linked_List<std::pair<Key, Value>>{
                     ++list_it;
                 }
                 else if (list_it->first == *key_it) {
-                    list_it = this->erase(list_it);
+                    list_it = DLL::erase(list_it);
                     ++key_it;
                 }
                 else {
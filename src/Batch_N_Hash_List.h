@@ -1,30 +1,140 @@
 #ifndef UMAP_WITH_SORTER_H
 #define UMAP_WITH_SORTER_H
+#include <algorithm>
 #include <vector>
 #include <limits>
 #include "Doubly_Linked_Hash_Map.h"
 #include "Radix_Sort.h"
+/*
+    The links stay sorted between writes: every key inserted since the last sort is recorded in pending_keys,
+    and removals keep the rest of the list in order. Writes must go through this class (not a
+    Doubly_Linked_Hash_Map reference) so inserts get recorded.
+*/
 template<typename Key, typename Value>
 class Batch_N_Hash_List : public Doubly_Linked_Hash_Map<Key, Value>{
     public:
         static constexpr Key NULL_KEY = std::numeric_limits<Key>::max();
+        using DLHM = Doubly_Linked_Hash_Map<Key, Value>;
         using Doubly_Linked_Hash_Map<Key, Value>::Doubly_Linked_Hash_Map;
         using omap_iter = typename Doubly_Linked_Hash_Map<Key, Value>::iterator;
         using NodeProps = typename Doubly_Linked_Hash_Map<Key, Value>::NodeProps;
+    private:
+        // Keys linked wherever their insert put them since the last sort; non-empty means the order is dirty.
+        // Removed keys may linger here and are skipped by the next sort
+        std::vector<Key> pending_keys;
+
+        // Takes a node out of the links, its umap entry stays
+        void unlink_key(const Key& key) {
+            NodeProps& node = this->umap.find(key)->second;
+            if (node.prev != NULL_KEY) {
+                this->umap.find(node.prev)->second.next = node.next;
+            }
+            else {
+                this->head = node.next;
+            }
+            if (node.next != NULL_KEY) {
+                this->umap.find(node.next)->second.prev = node.prev;
+            }
+            else {
+                this->tail = node.prev;
+            }
+        }
+
+        // Links an unlinked node in front of next_key, at the tail when next_key is NULL_KEY
+        void link_before(const Key& key, const Key& next_key) {
+            NodeProps& node = this->umap.find(key)->second;
+            node.next = next_key;
+            node.prev = next_key == NULL_KEY ? this->tail : this->umap.find(next_key)->second.prev;
+            if (node.prev != NULL_KEY) {
+                this->umap.find(node.prev)->second.next = key;
+            }
+            else {
+                this->head = key;
+            }
+            if (next_key != NULL_KEY) {
+                this->umap.find(next_key)->second.prev = key;
+            }
+            else {
+                this->tail = key;
+            }
+        }
+
+        // Records the key only when the insert added a node (addHead ignores keys already present)
+        void record_insert(const Key& key, size_t size_before) {
+            if (this->size() != size_before) {
+                pending_keys.push_back(key);
+            }
+        }
+
+    public:
         Batch_N_Hash_List() : Doubly_Linked_Hash_Map<Key, Value>() {}
 
+        void addHead(const Key& key, const Value& value) {
+            size_t size_before = this->size();
+            DLHM::addHead(key, value);
+            record_insert(key, size_before);
+        }
+
+        void addTail(const Key& key, const Value& value) {
+            size_t size_before = this->size();
+            DLHM::addTail(key, value);
+            record_insert(key, size_before);
+        }
+
+        void insertBefore(const Key& key, const Value& value, const Key& some_node) {
+            size_t size_before = this->size();
+            DLHM::insertBefore(key, value, some_node);
+            record_insert(key, size_before);
+        }
+
+        void insertAfter(const Key& key, const Value& value, const Key& some_node) {
+            size_t size_before = this->size();
+            DLHM::insertAfter(key, value, some_node);
+            record_insert(key, size_before);
+        }
+
+        void insertAt(const Key& key, const Value& value, const size_t index) {
+            size_t size_before = this->size();
+            DLHM::insertAt(key, value, index);
+            record_insert(key, size_before);
+        }
+
+        void clear() {
+            DLHM::clear();
+            pending_keys.clear();
+        }
+
+        /*
+            Incremental sort: the pending keys are radix sorted on their own and unlinked, which leaves the
+            older keys still in sorted order, then one forward walk links each pending key in front of the
+            first larger key. O(new + nodes up to the largest new key) hash lookups; a clean list returns
+            immediately.
+        */
         void sort_keys(){
-            // Convert umap to vector
-            std::vector<std::pair<Key, Value>> sorted_pairs;
-            for (auto iter = this->begin(); iter != this->end(); ++iter) {
-                sorted_pairs.push_back({iter->first, iter->second});
-            }
+            if (pending_keys.empty()) return;
 
-            // Sort
-            radix_sort(sorted_pairs.begin(),sorted_pairs.end(), [](const auto& p) { return p.first; });
+            radix_sort(pending_keys.begin(), pending_keys.end(), [](const Key& key) { return key; });
+            auto last = std::unique(pending_keys.begin(), pending_keys.end());
+            pending_keys.erase(last, pending_keys.end());
 
-            // Convert vector to umap
-            rebuild_sorted_links(sorted_pairs);
+            // Keys removed since their insert are gone from the umap and are dropped here
+            size_t live_count = 0;
+            for (const Key& key : pending_keys) {
+                if (this->contains(key)) {
+                    unlink_key(key);
+                    pending_keys[live_count++] = key;
+                }
+            }
+            pending_keys.erase(pending_keys.begin() + live_count, pending_keys.end());
+
+            Key nav_key = this->head;
+            for (const Key& key : pending_keys) {
+                while (nav_key != NULL_KEY and nav_key < key) {
+                    nav_key = this->umap.find(nav_key)->second.next;
+                }
+                link_before(key, nav_key);
+            }
+            pending_keys.clear();
         }
 
     /*
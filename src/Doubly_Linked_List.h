@@ -8,10 +8,13 @@
 #include <iterator>
 #include <stdexcept>
 #include <vector>
+#include "Node_Pool.h"
 
-template <typename T>
+// Node_Allocator builds and frees the nodes (see Node_Pool.h)
+template <typename T, template<typename> class Node_Allocator = Node_Pool>
 class Doubly_Linked_List {
-  private:
+  protected:
+    // Derived lists (Batch_List) relink nodes directly
     struct Node {
       T value;
       Node* next = nullptr;
@@ -23,6 +26,7 @@ class Doubly_Linked_List {
     Node* head = nullptr;
     Node* tail = nullptr;
     size_t node_count = 0;
+    Node_Allocator<Node> node_allocator;
 
   public:
     class const_iterator;
@@ -144,7 +148,18 @@ class Doubly_Linked_List {
       }
     };
 
-    template <typename L, typename G>
+  protected:
+    // Lets derived lists turn a node they found themselves into an iterator, and back
+    static iterator node_iterator(Node* node) {
+      return iterator(node);
+    }
+
+    static Node* iterator_node(iterator it) {
+      return it.current;
+    }
+
+  public:
+    template <size_t DIGIT_BITS, typename L, typename G>
     friend void radix_sort(L& list, G get_value);
 
     Doubly_Linked_List() = default;
@@ -219,7 +234,7 @@ class Doubly_Linked_List {
     }
 
     void addHead(const T& value) {
-      Node* newNode = new Node(value);
+      Node* newNode = node_allocator.create(value);
       if (!head) {
         head = tail = newNode;
       }
@@ -232,7 +247,7 @@ class Doubly_Linked_List {
     }
 
     void addTail(const T& value) {
-      Node* newNode = new Node(value);
+      Node* newNode = node_allocator.create(value);
       if (!tail) {
         head = tail = newNode;
       }
@@ -262,7 +277,7 @@ class Doubly_Linked_List {
         current = current->next;
       }
 
-      Node* newNode = new Node(value);
+      Node* newNode = node_allocator.create(value);
       newNode->prev = current->prev;
       newNode->next = current;
       current->prev->next = newNode;
@@ -279,7 +294,7 @@ class Doubly_Linked_List {
       } else {
         tail = nullptr;
       }
-      delete temp;
+      node_allocator.destroy(temp);
       node_count--;
       return true;
     }
@@ -293,7 +308,7 @@ class Doubly_Linked_List {
       } else {
         head = nullptr;
       }
-      delete temp;
+      node_allocator.destroy(temp);
       node_count--;
       return true;
     }
@@ -310,7 +325,7 @@ class Doubly_Linked_List {
 
       current->prev->next = current->next;
       current->next->prev = current->prev;
-      delete current;
+      node_allocator.destroy(current);
       node_count--;
       return true;
     }
@@ -324,7 +339,7 @@ class Doubly_Linked_List {
 
           temp->prev->next = temp->next;
           temp->next->prev = temp->prev;
-          delete temp;
+          node_allocator.destroy(temp);
           node_count--;
           return true;
         }
@@ -346,7 +361,7 @@ class Doubly_Linked_List {
           } else {
             current->prev->next = current->next;
             current->next->prev = current->prev;
-            delete current;
+            node_allocator.destroy(current);
             node_count--;
           }
           count++;
@@ -377,19 +392,23 @@ class Doubly_Linked_List {
         nextNode->prev = prevNode;
       }
 
-      delete curr;
+      node_allocator.destroy(curr);
       node_count--;
 
       return iterator(nextNode);
     }
 
     void clear() {
-      Node* current = head;
-      while (current) {
-        Node* next = current->next;
-        delete current;
-        current = next;
+      // Trivially destructible nodes go back with their slabs, no walk needed
+      if (!Node_Allocator<Node>::BULK_RELEASE) {
+        Node* current = head;
+        while (current) {
+          Node* next = current->next;
+          node_allocator.destroy(current);
+          current = next;
+        }
       }
+      node_allocator.release();
       head = nullptr;
       tail = nullptr;
       node_count = 0;
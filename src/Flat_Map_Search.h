@@ -0,0 +1,788 @@
+//
+// Search layouts for Radix_Flat_Map
+//
+#ifndef FLAT_MAP_SEARCH_H
+#define FLAT_MAP_SEARCH_H
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/*
+    A search layout is a policy with a nested Index<Key> that answers lower/upper bound queries over the
+    map's sorted, dense key array. A layout can keep its own copy of the keys or none at all.
+        rebuild(keys, size, first_changed) - after batch mutations, the keys are sorted and duplicate-free
+                                  and keys before first_changed kept their positions
+        invalidate()            - the keys changed without a rebuild, the secondary copy is stale
+        lower_bound / upper_bound(key, keys, size) - sorted position, size if there is none
+    A stale index must still answer correctly (falling back to binary search) until the next rebuild.
+*/
+
+#if defined(__GNUC__) || defined(__clang__)
+#define FLAT_MAP_PREFETCH(address) __builtin_prefetch(address)
+#else
+#define FLAT_MAP_PREFETCH(address) ((void)0)
+#endif
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define FLAT_MAP_AVX2 1
+#include <immintrin.h>
+#endif
+
+// Binary search stops branching once the window is this small and counts the rest in one pass
+const size_t FLAT_MAP_BLOCK_WINDOW = 16;
+
+inline bool flat_map_has_avx2() {
+#ifdef FLAT_MAP_AVX2
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    return has_avx2;
+#else
+    return false;
+#endif
+}
+
+// Number of keys < key (OR_EQUAL false) or keys <= key (OR_EQUAL true), branch-free so it works for any key type
+template<bool OR_EQUAL, typename Key>
+size_t scalar_block_count(const Key* keys, size_t n, const Key& key) {
+    size_t count = 0;
+    for (size_t i = 0; i < n; ++i) {
+        count += OR_EQUAL ? !(key < keys[i]) : keys[i] < key;
+    }
+    return count;
+}
+
+#ifdef FLAT_MAP_AVX2
+/*
+    Same count with one compare and movemask per vector. AVX2 only compares signed lanes, so unsigned
+    keys arrive with flip = sign bit and both sides are xor-ed into signed order first.
+*/
+template<bool OR_EQUAL, typename Lane, std::enable_if_t<sizeof(Lane) == 4, int> = 0>
+__attribute__((target("avx2")))
+size_t avx2_block_count(const Lane* keys, size_t n, Lane key, Lane flip) {
+    const __m256i flip_vec = _mm256_set1_epi32(flip);
+    const __m256i key_vec = _mm256_set1_epi32(key ^ flip);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i block = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i)), flip_vec);
+        __m256i mask = OR_EQUAL ? _mm256_cmpgt_epi32(block, key_vec) : _mm256_cmpgt_epi32(key_vec, block);
+        size_t hits = __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(mask)));
+        count += OR_EQUAL ? 8 - hits : hits;
+    }
+    for (; i < n; ++i) {
+        count += OR_EQUAL ? !((key ^ flip) < (keys[i] ^ flip)) : (keys[i] ^ flip) < (key ^ flip);
+    }
+    return count;
+}
+
+template<bool OR_EQUAL, typename Lane, std::enable_if_t<sizeof(Lane) == 8, int> = 0>
+__attribute__((target("avx2")))
+size_t avx2_block_count(const Lane* keys, size_t n, Lane key, Lane flip) {
+    const __m256i flip_vec = _mm256_set1_epi64x(flip);
+    const __m256i key_vec = _mm256_set1_epi64x(key ^ flip);
+    size_t count = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i block = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i)), flip_vec);
+        __m256i mask = OR_EQUAL ? _mm256_cmpgt_epi64(block, key_vec) : _mm256_cmpgt_epi64(key_vec, block);
+        size_t hits = __builtin_popcount(_mm256_movemask_pd(_mm256_castsi256_pd(mask)));
+        count += OR_EQUAL ? 4 - hits : hits;
+    }
+    for (; i < n; ++i) {
+        count += OR_EQUAL ? !((key ^ flip) < (keys[i] ^ flip)) : (keys[i] ^ flip) < (key ^ flip);
+    }
+    return count;
+}
+#endif
+
+template<typename Key, typename Enable = void>
+struct Flat_Map_Block_Count {
+    template<bool OR_EQUAL>
+    static size_t count(const Key* keys, size_t n, const Key& key) {
+        return scalar_block_count<OR_EQUAL>(keys, n, key);
+    }
+};
+
+// Signed and unsigned integers, but not bool or the character types: these have a signed counterpart
+template<typename Key, typename Enable = void>
+struct Flat_Map_Standard_Integer : std::false_type {};
+
+template<typename Key>
+struct Flat_Map_Standard_Integer<Key, std::enable_if_t<std::is_integral<Key>::value and not std::is_same<Key, bool>::value>>
+    : std::integral_constant<bool, std::is_same<Key, std::make_signed_t<Key>>::value
+                                   or std::is_same<Key, std::make_unsigned_t<Key>>::value> {};
+
+// 32 and 64-bit integers take the AVX2 path when the CPU has it (checked once). Lanes are the key's own
+// signed type, the only other type its keys may be read through
+template<typename Key>
+struct Flat_Map_Block_Count<Key, std::enable_if_t<Flat_Map_Standard_Integer<Key>::value
+                                                  and (sizeof(Key) == 4 or sizeof(Key) == 8)>> {
+    using Lane = std::make_signed_t<Key>;
+
+    template<bool OR_EQUAL>
+    static size_t count(const Key* keys, size_t n, const Key& key) {
+#ifdef FLAT_MAP_AVX2
+        if (flat_map_has_avx2()) {
+            Lane flip = std::is_signed<Key>::value ? 0 : std::numeric_limits<Lane>::min();
+            return avx2_block_count<OR_EQUAL>(reinterpret_cast<const Lane*>(keys), n, static_cast<Lane>(key), flip);
+        }
+#endif
+        return scalar_block_count<OR_EQUAL>(keys, n, key);
+    }
+};
+
+template<typename Key>
+size_t flat_map_lower_bound(const Key& key, const Key* keys, size_t low, size_t high) {
+    while(high - low > FLAT_MAP_BLOCK_WINDOW){
+        size_t midpoint = low + (high - low) / 2;
+        if(keys[midpoint] < key){
+            low = midpoint + 1;
+        }
+        else{
+            high = midpoint;
+        }
+    }
+    return low + Flat_Map_Block_Count<Key>::template count<false>(keys + low, high - low, key);
+}
+
+template<typename Key>
+size_t flat_map_upper_bound(const Key& key, const Key* keys, size_t low, size_t high) {
+    while(high - low > FLAT_MAP_BLOCK_WINDOW){
+        size_t midpoint = low + (high - low) / 2;
+        if(key < keys[midpoint]){
+            high = midpoint;
+        }
+        else{
+            low = midpoint + 1;
+        }
+    }
+    return low + Flat_Map_Block_Count<Key>::template count<true>(keys + low, high - low, key);
+}
+
+// key - first (key >= first) as a double, exact for integer keys up to 2^53 apart
+template<typename Key>
+double flat_map_key_distance(const Key& key, const Key& first, std::true_type) {
+    using Unsigned_Key = std::make_unsigned_t<Key>;
+    return static_cast<double>(static_cast<Unsigned_Key>(static_cast<Unsigned_Key>(key) - static_cast<Unsigned_Key>(first)));
+}
+
+template<typename Key>
+double flat_map_key_distance(const Key& key, const Key& first, std::false_type) {
+    return static_cast<double>(key) - static_cast<double>(first);
+}
+
+template<typename Key>
+double flat_map_key_distance(const Key& key, const Key& first) {
+    return flat_map_key_distance(key, first, std::is_integral<Key>());
+}
+
+// keys[pos] sorts before the answer: keys < key for lower bounds, keys <= key for upper bounds
+template<bool OR_EQUAL, typename Key>
+bool flat_map_before(const Key& probe, const Key& key) {
+    return OR_EQUAL ? !(key < probe) : probe < key;
+}
+
+template<bool OR_EQUAL, typename Key>
+size_t flat_map_bound(const Key& key, const Key* keys, size_t low, size_t high) {
+    return OR_EQUAL ? flat_map_upper_bound(key, keys, low, high) : flat_map_lower_bound(key, keys, low, high);
+}
+
+/*
+    Exponential search outward from hint: 1, 2, 4, ... steps until the answer is bracketed, then a
+    bounded binary search. O(log d) for an answer d positions away, so monotone probe sequences
+    (scan-then-probe, merges) cost almost nothing per lookup.
+*/
+template<bool OR_EQUAL, typename Key>
+size_t flat_map_gallop(const Key& key, const Key* keys, size_t size, size_t hint) {
+    hint = std::min(hint, size);
+    if (hint < size and flat_map_before<OR_EQUAL>(keys[hint], key)) {
+        // answer is right of hint
+        size_t low = hint + 1;
+        size_t step = 1;
+        while (low + step - 1 < size and flat_map_before<OR_EQUAL>(keys[low + step - 1], key)) {
+            low += step;
+            step *= 2;
+        }
+        return flat_map_bound<OR_EQUAL>(key, keys, low, std::min(size, low + step - 1));
+    }
+    // answer is at or left of hint
+    size_t high = hint;
+    size_t step = 1;
+    while (high >= step and not flat_map_before<OR_EQUAL>(keys[high - step], key)) {
+        high -= step;
+        step *= 2;
+    }
+    return flat_map_bound<OR_EQUAL>(key, keys, high >= step ? high - step + 1 : 0, high);
+}
+
+/*
+    Interpolation search: probe where the key would sit if the keys were evenly spread, O(log log N)
+    probes on uniform keys. A probe that fails to halve the range is followed by a binary step, so
+    skewed keys cost at most twice a binary search. Finishes with the block count like binary search.
+*/
+template<bool OR_EQUAL, typename Key>
+size_t flat_map_interpolate(const Key& key, const Key* keys, size_t size) {
+    size_t low = 0;
+    size_t high = size;
+    while (high - low > FLAT_MAP_BLOCK_WINDOW) {
+        if (not flat_map_before<OR_EQUAL>(keys[low], key)) {
+            return low;
+        }
+        if (flat_map_before<OR_EQUAL>(keys[high - 1], key)) {
+            return high;
+        }
+        size_t range = high - low;
+        double fraction = flat_map_key_distance(key, keys[low]) / flat_map_key_distance(keys[high - 1], keys[low]);
+        size_t probe = low + static_cast<size_t>(std::min(std::max(0.0, fraction), 1.0) * static_cast<double>(high - 1 - low));
+        if (flat_map_before<OR_EQUAL>(keys[probe], key)) {
+            low = probe + 1;
+        }
+        else {
+            high = probe;
+        }
+        if ((high - low) * 2 > range) {
+            size_t midpoint = low + (high - low) / 2;
+            if (flat_map_before<OR_EQUAL>(keys[midpoint], key)) {
+                low = midpoint + 1;
+            }
+            else {
+                high = midpoint;
+            }
+        }
+    }
+    return low + Flat_Map_Block_Count<Key>::template count<OR_EQUAL>(keys + low, high - low, key);
+}
+
+// Plain binary search over the map's own keys, nothing to rebuild
+struct Binary_Search {
+    template<typename Key>
+    class Index {
+        public:
+        void rebuild(const Key*, size_t, size_t) {}
+
+        void invalidate() {}
+
+        size_t lower_bound(const Key& key, const Key* keys, size_t size) const {
+            return flat_map_lower_bound(key, keys, 0, size);
+        }
+
+        size_t upper_bound(const Key& key, const Key* keys, size_t size) const {
+            return flat_map_upper_bound(key, keys, 0, size);
+        }
+    };
+};
+
+/*
+    Eytzinger (BFS order) copy of the keys: node k has children 2k and 2k + 1, so the first levels of
+    every search share cache lines and the descent is branchless. Each step prefetches the cache line
+    holding the node's descendants several levels down, hiding most of the memory latency on large maps.
+    sorted_positions maps a node back to its index in the map, slot 0 holds size ("not found").
+    An invalidated copy falls back to binary search until the next rebuild.
+*/
+struct Eytzinger_Search {
+    template<typename Key>
+    class Index {
+        std::vector<Key> eytzinger_keys;        // 1-indexed, slot 0 unused
+        std::vector<size_t> sorted_positions;
+        bool stale = true;
+
+        // how many consecutive nodes share one 64-byte line, the prefetch jumps that many levels ahead
+        static constexpr size_t keys_per_line = sizeof(Key) >= 64 ? 1 : 64 / sizeof(Key);
+
+        size_t build(size_t sorted_pos, size_t node, const Key* keys, size_t size) {
+            // in-order walk of the implicit tree, depth is log2(size)
+            if (node <= size) {
+                sorted_pos = build(sorted_pos, 2 * node, keys, size);
+                eytzinger_keys[node] = keys[sorted_pos];
+                sorted_positions[node] = sorted_pos++;
+                sorted_pos = build(sorted_pos, 2 * node + 1, keys, size);
+            }
+            return sorted_pos;
+        }
+
+        // the descent ends below a leaf, dropping the trailing right turns (and one left turn) gives the answer
+        size_t resolve(size_t node) const {
+            while (node & 1) {
+                node >>= 1;
+            }
+            node >>= 1;
+            return sorted_positions[node];
+        }
+
+        public:
+        void rebuild(const Key* keys, size_t size, size_t) {
+            eytzinger_keys.resize(size + 1);
+            sorted_positions.resize(size + 1);
+            sorted_positions[0] = size;
+            build(0, 1, keys, size);
+            stale = false;
+        }
+
+        void invalidate() {
+            stale = true;
+        }
+
+        bool is_stale() const {
+            return stale;
+        }
+
+        size_t lower_bound(const Key& key, const Key* keys, size_t size) const {
+            if (stale) {
+                return flat_map_lower_bound(key, keys, 0, size);
+            }
+            const Key* tree = eytzinger_keys.data();
+            size_t node = 1;
+            while (node <= size) {
+                FLAT_MAP_PREFETCH(tree + node * keys_per_line);
+                node = 2 * node + (tree[node] < key);
+            }
+            return resolve(node);
+        }
+
+        size_t upper_bound(const Key& key, const Key* keys, size_t size) const {
+            if (stale) {
+                return flat_map_upper_bound(key, keys, 0, size);
+            }
+            const Key* tree = eytzinger_keys.data();
+            size_t node = 1;
+            while (node <= size) {
+                FLAT_MAP_PREFETCH(tree + node * keys_per_line);
+                node = 2 * node + !(key < tree[node]);
+            }
+            return resolve(node);
+        }
+    };
+};
+
+/*
+    S-tree: a frozen implicit B+-tree over the sorted keys with FLAT_MAP_BLOCK_WINDOW keys per node and
+    one more child than keys. The map's own key array is the leaf level, so only the internal levels
+    (about N / 16 keys) are stored. Node k of a level has children k * 17 + i one level down, and its
+    separator i is the smallest key under child i + 1; separators past the end repeat the largest key so
+    a probe beyond it walks off the end and clamps to size. Each level costs one block count over 16 keys
+    (the AVX2 kernel for integers) and 4-byte keys get one cache line per node. Built in O(N) from the
+    sorted keys, stale after invalidate() like Eytzinger_Search.
+*/
+struct S_Tree_Search {
+    template<typename Key>
+    class Index {
+        static constexpr size_t node_keys = FLAT_MAP_BLOCK_WINDOW;
+        static constexpr size_t node_children = node_keys + 1;
+
+        std::vector<Key> separators;            // internal levels, root level first
+        std::vector<size_t> level_offsets;      // level_offsets[h] = first separator of level h, leaves are h = 0
+        std::vector<size_t> level_sizes;        // level_sizes[h] = nodes on level h, leaf blocks are h = 0
+        bool stale = true;
+
+        // first separator slot that starts on a 64-byte boundary when the key size allows it
+        size_t aligned_start() const {
+            uintptr_t misalignment = reinterpret_cast<uintptr_t>(separators.data()) % 64;
+            if (misalignment == 0 or (64 - misalignment) % sizeof(Key) != 0) {
+                return 0;
+            }
+            return (64 - misalignment) / sizeof(Key);
+        }
+
+        template<bool OR_EQUAL>
+        size_t descend(const Key& key, const Key* keys, size_t size) const {
+            size_t node = 0;
+            for (size_t h = level_offsets.size() - 1; h > 0; --h) {
+                const Key* separator_block = separators.data() + level_offsets[h] + node * node_keys;
+                node = node * node_children + Flat_Map_Block_Count<Key>::template count<OR_EQUAL>(separator_block, node_keys, key);
+                // a child past the last node of its level only holds positions past the end, and has no separators to read
+                if (node >= level_sizes[h - 1]) {
+                    return size;
+                }
+            }
+            size_t first = node * node_keys;
+            if (first >= size) {
+                return size;
+            }
+            // size_t(...) takes a copy: std::min binds references, which would ODR-use node_keys in C++14
+            size_t block_size = std::min(size_t(node_keys), size - first);
+            return first + Flat_Map_Block_Count<Key>::template count<OR_EQUAL>(keys + first, block_size, key);
+        }
+
+        public:
+        void rebuild(const Key* keys, size_t size, size_t) {
+            // node count per internal level, bottom up
+            std::vector<size_t> level_nodes;
+            size_t nodes = (size + node_keys - 1) / node_keys;
+            level_sizes.assign(1, nodes);
+            while (nodes > 1) {
+                nodes = (nodes + node_keys) / node_children;
+                level_nodes.push_back(nodes);
+                level_sizes.push_back(nodes);
+            }
+
+            size_t separator_count = 0;
+            for (size_t count : level_nodes) {
+                separator_count += count * node_keys;
+            }
+            separators.clear();
+            separators.resize(separator_count + 64 / sizeof(Key) + 1);
+
+            // root level first so the top of every search shares the same few lines
+            level_offsets.assign(level_nodes.size() + 1, 0);
+            size_t offset = aligned_start();
+            for (size_t h = level_nodes.size(); h > 0; --h) {
+                level_offsets[h] = offset;
+                offset += level_nodes[h - 1] * node_keys;
+            }
+
+            for (size_t h = 1; h <= level_nodes.size(); ++h) {
+                for (size_t node = 0; node < level_nodes[h - 1]; ++node) {
+                    for (size_t i = 0; i < node_keys; ++i) {
+                        // leftmost leaf block under child i + 1
+                        size_t block = node * node_children + i + 1;
+                        for (size_t level = h - 1; level > 0; --level) {
+                            block *= node_children;
+                        }
+                        size_t first = block * node_keys;
+                        separators[level_offsets[h] + node * node_keys + i] = first < size ? keys[first] : keys[size - 1];
+                    }
+                }
+            }
+            stale = false;
+        }
+
+        void invalidate() {
+            stale = true;
+        }
+
+        bool is_stale() const {
+            return stale;
+        }
+
+        // separators kept next to the keys, padding included
+        size_t memory_bytes() const {
+            return separators.capacity() * sizeof(Key) + (level_offsets.capacity() + level_sizes.capacity()) * sizeof(size_t);
+        }
+
+        size_t lower_bound(const Key& key, const Key* keys, size_t size) const {
+            if (stale) {
+                return flat_map_lower_bound(key, keys, 0, size);
+            }
+            return descend<false>(key, keys, size);
+        }
+
+        size_t upper_bound(const Key& key, const Key* keys, size_t size) const {
+            if (stale) {
+                return flat_map_upper_bound(key, keys, 0, size);
+            }
+            return descend<true>(key, keys, size);
+        }
+    };
+};
+
+/*
+    Learned layout: a piecewise-linear model that predicts every key's position within EPSILON, so a
+    lookup picks its segment from the (few) segment start keys and searches only a 2 * EPSILON window.
+    Segments are fitted greedily in one pass with a shrinking slope cone: a segment grows while some
+    slope keeps all its keys within EPSILON of their positions. A merge only refits from the segment
+    holding the first changed position. Prediction misses from rounding are caught at the window edges
+    and finished with binary search, so answers never depend on the model being exact.
+    Keys must be arithmetic; the fit works on distances from each segment's first key.
+*/
+template<size_t EPSILON = 32>
+struct Learned_Search {
+    template<typename Key>
+    class Index {
+        static_assert(std::is_arithmetic<Key>::value and not std::is_same<Key, bool>::value,
+                      "the learned layout models numeric keys");
+
+        struct Segment {
+            size_t first_pos;
+            double slope;
+            size_t max_error;
+            double error_sum;
+        };
+
+        std::vector<Key> segment_keys;      // first key of every segment, searched to pick the model
+        std::vector<Segment> segments;
+        size_t modeled_size = 0;
+        bool stale = true;
+
+        void fit_from(const Key* keys, size_t size, size_t first) {
+            const double epsilon = static_cast<double>(EPSILON);
+            while (first < size) {
+                double slope_low = 0;
+                double slope_high = std::numeric_limits<double>::infinity();
+                size_t end = first + 1;
+                for (; end < size; ++end) {
+                    double dx = flat_map_key_distance(keys[end], keys[first]);
+                    double dy = static_cast<double>(end - first);
+                    if (dx <= 0 or (dy - epsilon) / dx > slope_high or (dy + epsilon) / dx < slope_low) {
+                        break;
+                    }
+                    slope_low = std::max(slope_low, (dy - epsilon) / dx);
+                    slope_high = std::min(slope_high, (dy + epsilon) / dx);
+                }
+                Segment segment{first, end - first == 1 ? 0.0 : (slope_low + slope_high) / 2, 0, 0.0};
+
+                // error over the segment's own keys, still in cache
+                for (size_t pos = first; pos < end; ++pos) {
+                    double error = std::fabs(segment.slope * flat_map_key_distance(keys[pos], keys[first]) - static_cast<double>(pos - first));
+                    segment.max_error = std::max(segment.max_error, static_cast<size_t>(std::ceil(error)));
+                    segment.error_sum += error;
+                }
+
+                segment_keys.push_back(keys[first]);
+                segments.push_back(segment);
+                first = end;
+            }
+            modeled_size = size;
+        }
+
+        // predicted window [low, high) inside the segment's range [first_pos, next_first]
+        void window(const Key& key, size_t segment_index, size_t& first_pos, size_t& next_first,
+                    size_t& low, size_t& high) const {
+            const Segment& segment = segments[segment_index];
+            first_pos = segment.first_pos;
+            next_first = segment_index + 1 < segments.size() ? segments[segment_index + 1].first_pos : modeled_size;
+            double predicted = static_cast<double>(first_pos) + segment.slope * flat_map_key_distance(key, segment_keys[segment_index]);
+            size_t guess = static_cast<size_t>(std::min(predicted, static_cast<double>(next_first)));
+            low = guess > first_pos + EPSILON + 1 ? guess - EPSILON - 1 : first_pos;
+            high = std::min(next_first, guess + EPSILON + 2);
+        }
+
+        public:
+        void rebuild(const Key* keys, size_t size, size_t first_changed) {
+            if (stale or first_changed == 0 or segments.empty()) {
+                segment_keys.clear();
+                segments.clear();
+                fit_from(keys, size, 0);
+            }
+            else {
+                // positions before first_changed did not move, refit from the segment that holds it
+                size_t keep = segments.size();
+                while (keep > 0 and segments[keep - 1].first_pos > first_changed) {
+                    --keep;
+                }
+                keep = keep > 0 ? keep - 1 : 0;
+                size_t refit_from = segments[keep].first_pos;
+                segment_keys.resize(keep);
+                segments.resize(keep);
+                fit_from(keys, size, refit_from);
+            }
+            stale = false;
+        }
+
+        void invalidate() {
+            stale = true;
+        }
+
+        bool is_stale() const {
+            return stale;
+        }
+
+        size_t segment_count() const {
+            return segments.size();
+        }
+
+        size_t memory_bytes() const {
+            return segment_keys.capacity() * sizeof(Key) + segments.capacity() * sizeof(Segment);
+        }
+
+        // largest |predicted - actual| position over all keys, at most EPSILON up to rounding
+        size_t max_error() const {
+            size_t error = 0;
+            for (const Segment& segment : segments) {
+                error = std::max(error, segment.max_error);
+            }
+            return error;
+        }
+
+        double mean_error() const {
+            double error_sum = 0;
+            for (const Segment& segment : segments) {
+                error_sum += segment.error_sum;
+            }
+            return modeled_size == 0 ? 0.0 : error_sum / static_cast<double>(modeled_size);
+        }
+
+        size_t lower_bound(const Key& key, const Key* keys, size_t size) const {
+            if (stale or segments.empty()) {
+                return flat_map_lower_bound(key, keys, 0, size);
+            }
+            size_t segment_index = flat_map_upper_bound(key, segment_keys.data(), 0, segment_keys.size());
+            if (segment_index == 0) {
+                return 0;
+            }
+            size_t first_pos, next_first, low, high;
+            window(key, segment_index - 1, first_pos, next_first, low, high);
+            size_t pos = flat_map_lower_bound(key, keys, low, high);
+            if (pos == low and low > first_pos and not (keys[low - 1] < key)) {
+                return flat_map_lower_bound(key, keys, first_pos, low);
+            }
+            if (pos == high and high < next_first and keys[high] < key) {
+                return flat_map_lower_bound(key, keys, high, next_first);
+            }
+            return pos;
+        }
+
+        size_t upper_bound(const Key& key, const Key* keys, size_t size) const {
+            if (stale or segments.empty()) {
+                return flat_map_upper_bound(key, keys, 0, size);
+            }
+            size_t segment_index = flat_map_upper_bound(key, segment_keys.data(), 0, segment_keys.size());
+            if (segment_index == 0) {
+                return 0;
+            }
+            size_t first_pos, next_first, low, high;
+            window(key, segment_index - 1, first_pos, next_first, low, high);
+            size_t pos = flat_map_upper_bound(key, keys, low, high);
+            if (pos == low and low > first_pos and key < keys[low - 1]) {
+                return flat_map_upper_bound(key, keys, first_pos, low);
+            }
+            if (pos == high and high < next_first and not (key < keys[high])) {
+                return flat_map_upper_bound(key, keys, high, next_first);
+            }
+            return pos;
+        }
+    };
+};
+
+// Interpolation search over the map's own keys for evenly spread numeric keys, nothing to rebuild
+struct Interpolation_Search {
+    template<typename Key>
+    class Index {
+        static_assert(std::is_arithmetic<Key>::value and not std::is_same<Key, bool>::value,
+                      "interpolation search needs numeric keys");
+
+        public:
+        void rebuild(const Key*, size_t, size_t) {}
+
+        void invalidate() {}
+
+        size_t lower_bound(const Key& key, const Key* keys, size_t size) const {
+            return flat_map_interpolate<false>(key, keys, size);
+        }
+
+        size_t upper_bound(const Key& key, const Key* keys, size_t size) const {
+            return flat_map_interpolate<true>(key, keys, size);
+        }
+    };
+};
+
+/*
+    Galloping from the last answer: every lookup starts where the previous one ended, so a run of
+    increasing (or decreasing) probes walks the map in O(log distance) each instead of O(log N).
+    The remembered position is per map and unsynchronized, share the map between threads only with
+    another layout.
+*/
+struct Galloping_Search {
+    template<typename Key>
+    class Index {
+        mutable size_t last_position = 0;
+
+        public:
+        void rebuild(const Key*, size_t, size_t) {}
+
+        void invalidate() {}
+
+        size_t lower_bound(const Key& key, const Key* keys, size_t size) const {
+            last_position = flat_map_gallop<false>(key, keys, size, last_position);
+            return last_position;
+        }
+
+        size_t upper_bound(const Key& key, const Key* keys, size_t size) const {
+            last_position = flat_map_gallop<true>(key, keys, size, last_position);
+            return last_position;
+        }
+    };
+};
+
+/*
+    std::string keys: every key's first 8 bytes are cached big-endian in key_prefixes, so the binary
+    search compares integers and only follows the string pointer when two prefixes are equal.
+    A rebuild recomputes the prefixes from the first changed position, stale after invalidate().
+*/
+struct String_Prefix_Search {
+    template<typename Key>
+    class Index {
+        static_assert(std::is_same<Key, std::string>::value, "prefix search needs std::string keys");
+
+        std::vector<uint64_t> key_prefixes;
+        bool stale = true;
+
+        static uint64_t key_prefix(const Key& key) {
+            uint64_t prefix = 0;
+            size_t prefix_bytes = std::min(key.size(), sizeof(uint64_t));
+            for (size_t i = 0; i < prefix_bytes; ++i) {
+                prefix |= static_cast<uint64_t>(static_cast<unsigned char>(key[i])) << (56 - 8 * i);
+            }
+            return prefix;
+        }
+
+        template<bool OR_EQUAL>
+        size_t bound(const Key& key, const Key* keys, size_t size) const {
+            uint64_t prefix = key_prefix(key);
+            size_t low = 0;
+            size_t high = size;
+            while (low < high) {
+                size_t midpoint = low + (high - low) / 2;
+                // <0, 0 or >0 like std::string::compare, prefix first
+                int order = key_prefixes[midpoint] != prefix ? (key_prefixes[midpoint] < prefix ? -1 : 1)
+                                                             : keys[midpoint].compare(key);
+                if (OR_EQUAL ? order <= 0 : order < 0) {
+                    low = midpoint + 1;
+                }
+                else {
+                    high = midpoint;
+                }
+            }
+            return low;
+        }
+
+        public:
+        void rebuild(const Key* keys, size_t size, size_t first_changed) {
+            if (stale) {
+                first_changed = 0;
+            }
+            key_prefixes.resize(size);
+            for (size_t i = first_changed; i < size; ++i) {
+                key_prefixes[i] = key_prefix(keys[i]);
+            }
+            stale = false;
+        }
+
+        void invalidate() {
+            stale = true;
+        }
+
+        bool is_stale() const {
+            return stale;
+        }
+
+        size_t lower_bound(const Key& key, const Key* keys, size_t size) const {
+            if (stale) {
+                return flat_map_lower_bound(key, keys, 0, size);
+            }
+            return bound<false>(key, keys, size);
+        }
+
+        size_t upper_bound(const Key& key, const Key* keys, size_t size) const {
+            if (stale) {
+                return flat_map_upper_bound(key, keys, 0, size);
+            }
+            return bound<true>(key, keys, size);
+        }
+    };
+};
+
+// Layout a Radix_Flat_Map uses when none is given
+template<typename Key>
+struct Flat_Map_Default_Search {
+    using type = Binary_Search;
+};
+
+template<>
+struct Flat_Map_Default_Search<std::string> {
+    using type = String_Prefix_Search;
+};
+
+#endif //FLAT_MAP_SEARCH_H
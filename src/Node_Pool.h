@@ -0,0 +1,126 @@
+//
+// Node allocators for the linked containers (AVL_Tree, Treap, Doubly_Linked_List)
+//
+
+#ifndef NODE_POOL_H
+#define NODE_POOL_H
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Slab sizes in nodes: small containers stay small, large ones allocate rarely
+const size_t NODE_POOL_FIRST_SLAB = 32;
+const size_t NODE_POOL_MAX_SLAB = 4096;
+
+/*
+    Containers take their node allocator as a template template parameter and only use create, destroy
+    and release. create carves nodes out of slabs that double in size up to NODE_POOL_MAX_SLAB, so nodes
+    built one after another sit next to each other; destroy threads the slot onto a freelist that create
+    reuses first. release hands every slab back at once: when nodes are trivially destructible
+    (BULK_RELEASE) clear() skips the per-node walk entirely, otherwise it destroys each node first.
+*/
+template<typename Node>
+class Node_Pool {
+    union Slot {
+        Slot* next_free;
+        typename std::aligned_storage<sizeof(Node), alignof(Node)>::type storage;
+    };
+
+    std::vector<std::unique_ptr<Slot[]>> slabs;
+    Slot* free_slots = nullptr;
+    size_t slab_capacity = 0;
+    size_t slab_used = 0;
+
+    public:
+    static constexpr bool BULK_RELEASE = std::is_trivially_destructible<Node>::value;
+
+    Node_Pool() = default;
+    Node_Pool(const Node_Pool&) = delete;
+    Node_Pool& operator=(const Node_Pool&) = delete;
+
+    // Moves take the slabs and the freelist over and leave the source an empty pool
+    Node_Pool(Node_Pool&& other) noexcept
+        : slabs(std::move(other.slabs)), free_slots(std::exchange(other.free_slots, nullptr)),
+          slab_capacity(std::exchange(other.slab_capacity, 0)), slab_used(std::exchange(other.slab_used, 0)) {
+        other.slabs.clear();
+    }
+
+    // Same as release() first: nodes still alive in this pool must have been destroyed unless BULK_RELEASE
+    Node_Pool& operator=(Node_Pool&& other) noexcept {
+        if (this != &other) {
+            slabs = std::move(other.slabs);
+            other.slabs.clear();
+            free_slots = std::exchange(other.free_slots, nullptr);
+            slab_capacity = std::exchange(other.slab_capacity, 0);
+            slab_used = std::exchange(other.slab_used, 0);
+        }
+        return *this;
+    }
+
+    template<typename... Args>
+    Node* create(Args&&... args) {
+        Slot* slot;
+        if (free_slots != nullptr) {
+            slot = free_slots;
+            free_slots = slot->next_free;
+        }
+        else {
+            if (slab_used == slab_capacity) {
+                slab_capacity = slabs.empty() ? NODE_POOL_FIRST_SLAB : std::min(slab_capacity * 2, NODE_POOL_MAX_SLAB);
+                slabs.emplace_back(new Slot[slab_capacity]);
+                slab_used = 0;
+            }
+            slot = &slabs.back()[slab_used++];
+        }
+        try {
+            return new (&slot->storage) Node(std::forward<Args>(args)...);
+        }
+        catch (...) {
+            slot->next_free = free_slots;
+            free_slots = slot;
+            throw;
+        }
+    }
+
+    void destroy(Node* node) {
+        node->~Node();
+        Slot* slot = reinterpret_cast<Slot*>(node);
+        slot->next_free = free_slots;
+        free_slots = slot;
+    }
+
+    // Frees every slab; nodes still alive must have been destroyed unless BULK_RELEASE
+    void release() {
+        slabs.clear();
+        free_slots = nullptr;
+        slab_capacity = 0;
+        slab_used = 0;
+    }
+
+    size_t slab_count() const {
+        return slabs.size();
+    }
+};
+
+// Plain new/delete per node, the layout the containers had before Node_Pool
+template<typename Node>
+struct Heap_Node_Allocator {
+    static constexpr bool BULK_RELEASE = false;
+
+    template<typename... Args>
+    Node* create(Args&&... args) {
+        return new Node(std::forward<Args>(args)...);
+    }
+
+    void destroy(Node* node) {
+        delete node;
+    }
+
+    void release() {}
+};
+
+#endif //NODE_POOL_H
@@ -0,0 +1,68 @@
+//
+// Subtree-size augmentation shared by AVL_Tree and Treap for rank/select queries
+//
+
+#ifndef ORDER_STATISTICS_H
+#define ORDER_STATISTICS_H
+#include <cstddef>
+#include <type_traits>
+
+// Tree nodes derive from this; it is an empty base when the tree is built without order statistics
+template<bool ORDER_STATISTICS>
+struct Subtree_Size {
+    size_t subtree_size = 1;
+};
+
+template<>
+struct Subtree_Size<false> {};
+
+template<typename Node>
+size_t subtree_size(const Node* node) {
+    return node == nullptr ? 0 : node->subtree_size;
+}
+
+// Recomputes a node's size from its children, a no-op without the augmentation
+template<typename Node>
+void update_subtree_size(Node* node, std::true_type) {
+    node->subtree_size = 1 + subtree_size(node->left) + subtree_size(node->right);
+}
+
+template<typename Node>
+void update_subtree_size(Node*, std::false_type) {}
+
+// Number of keys below key (OR_EQUAL: at most key), one root-to-leaf descent
+template<bool OR_EQUAL, typename Node, typename Key>
+size_t subtree_rank(const Node* nav_node, const Key& key) {
+    size_t rank = 0;
+    while (nav_node != nullptr) {
+        if (nav_node->data.first < key or (OR_EQUAL and not (key < nav_node->data.first))) {
+            rank += subtree_size(nav_node->left) + 1;
+            nav_node = nav_node->right;
+        }
+        else {
+            nav_node = nav_node->left;
+        }
+    }
+    return rank;
+}
+
+// The k-th smallest node (0-based), nullptr when k >= size
+template<typename Node>
+Node* subtree_select(Node* nav_node, size_t k) {
+    while (nav_node != nullptr) {
+        size_t left_size = subtree_size(nav_node->left);
+        if (k < left_size) {
+            nav_node = nav_node->left;
+        }
+        else if (k == left_size) {
+            return nav_node;
+        }
+        else {
+            k -= left_size + 1;
+            nav_node = nav_node->right;
+        }
+    }
+    return nullptr;
+}
+
+#endif //ORDER_STATISTICS_H
@@ -0,0 +1,59 @@
+//
+// Root-to-node path storage for the tree rebalancing code, no heap allocation on balanced trees
+//
+
+#ifndef PATH_BUFFER_H
+#define PATH_BUFFER_H
+#include <cstddef>
+#include <vector>
+
+// An AVL tree of 2^64 nodes is at most ~1.44 * 64 = 92 levels deep, a treap is O(log N) deep in expectation
+const size_t TREE_PATH_CAPACITY = 96;
+
+// Vector-like stack kept in an inline array; entries past CAPACITY spill to a vector (degenerate treaps only)
+template<typename T, size_t CAPACITY = TREE_PATH_CAPACITY>
+class Path_Buffer {
+    T inline_items[CAPACITY];
+    std::vector<T> spilled_items;
+    size_t item_count = 0;
+
+    public:
+    void push_back(const T& item) {
+        if (item_count < CAPACITY) {
+            inline_items[item_count] = item;
+        }
+        else {
+            spilled_items.push_back(item);
+        }
+        ++item_count;
+    }
+
+    void pop_back() {
+        --item_count;
+        if (item_count >= CAPACITY) {
+            spilled_items.pop_back();
+        }
+    }
+
+    T& operator[](size_t i) {
+        return i < CAPACITY ? inline_items[i] : spilled_items[i - CAPACITY];
+    }
+
+    const T& operator[](size_t i) const {
+        return i < CAPACITY ? inline_items[i] : spilled_items[i - CAPACITY];
+    }
+
+    T& back() {
+        return (*this)[item_count - 1];
+    }
+
+    size_t size() const {
+        return item_count;
+    }
+
+    bool empty() const {
+        return item_count == 0;
+    }
+};
+
+#endif //PATH_BUFFER_H
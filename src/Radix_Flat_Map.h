@@ -4,23 +4,498 @@
 #ifndef RADIX_FLAT_MAP_H
 #define RADIX_FLAT_MAP_H
 #include "Radix_Sort.h"
+#include "Flat_Map_Search.h"
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <string>
 #include <vector>
 #include <limits>
+#include <type_traits>
+
+// Smallest delta buffer before single-key writes are merged into the flat arrays
+const size_t FLAT_MAP_DELTA_MIN = 256;
+
+// Sorts by key: radix_sort for fixed-width keys, string_radix_sort (in place, not stable) for std::string
+template<typename Key>
+struct Flat_Map_Key_Sort {
+    template<typename RandomAccessIt, typename Getter>
+    static void sort(RandomAccessIt begin, RandomAccessIt end, Getter get_key,
+                     Radix_Sort_Mode mode = Radix_Sort_Mode::LSD_BUFFERED, size_t thread_count = 1) {
+        radix_sort(begin, end, get_key, mode, thread_count);
+    }
+
+    // Sorts two parallel arrays by the keys, see radix_sort_by_key
+    template<typename KeyIt, typename ValueIt>
+    static void sort_by_key(KeyIt keys_begin, KeyIt keys_end, ValueIt values_begin,
+                            Radix_Sort_Mode mode = Radix_Sort_Mode::LSD_BUFFERED, size_t thread_count = 1) {
+        radix_sort_by_key(keys_begin, keys_end, values_begin, mode, thread_count);
+    }
+};
 
-template<typename Key, typename Value>
+template<>
+struct Flat_Map_Key_Sort<std::string> {
+    template<typename RandomAccessIt, typename Getter>
+    static void sort(RandomAccessIt begin, RandomAccessIt end, Getter get_key,
+                     Radix_Sort_Mode = Radix_Sort_Mode::LSD_BUFFERED, size_t = 1) {
+        string_radix_sort(begin, end, get_key);
+    }
+
+    // Sorts positions by the strings they point at, then moves every key and value once
+    template<typename KeyIt, typename ValueIt>
+    static void sort_by_key(KeyIt keys_begin, KeyIt keys_end, ValueIt values_begin,
+                            Radix_Sort_Mode = Radix_Sort_Mode::LSD_BUFFERED, size_t = 1) {
+        size_t range_size = std::distance(keys_begin, keys_end);
+        if (range_size <= 1) return;
+
+        auto* keys = &(*keys_begin);
+        std::vector<size_t> order(range_size);
+        for (size_t i = 0; i < range_size; ++i) {
+            order[i] = i;
+        }
+        string_radix_sort(order.begin(), order.end(), [keys](size_t i) -> const std::string& { return keys[i]; });
+        radix_permute_by_order(keys, &(*values_begin), order.data(), range_size, [](size_t& index) -> size_t& { return index; });
+    }
+};
+
+// One stored value, so bool values get real bool& references instead of std::vector<bool> bit proxies
+template<typename Value>
+struct Flat_Map_Slot {
+    Value value;
+};
+
+// What a batch write does with a key the map already holds (and with repeats inside the batch)
+enum class Batch_Duplicate_Policy { KEEP_OLD, OVERWRITE, COMBINE };
+
+// Collapses runs of equal keys in a sorted run: first one kept, last one kept, or values folded left to right.
+// key_at(i) and value_at(i) address the run, returns its collapsed size
+template<typename Key_At, typename Value_At, typename Combine>
+size_t collapse_sorted_run(size_t size, Key_At key_at, Value_At value_at, Batch_Duplicate_Policy policy, Combine combine) {
+    if (size == 0) return 0;
+
+    size_t write_pos = 0;
+    for (size_t read_pos = 1; read_pos < size; ++read_pos) {
+        if (key_at(read_pos) != key_at(write_pos)) {
+            ++write_pos;
+            if (write_pos != read_pos) {
+                key_at(write_pos) = std::move(key_at(read_pos));
+                value_at(write_pos) = std::move(value_at(read_pos));
+            }
+        }
+        else if (policy == Batch_Duplicate_Policy::OVERWRITE) {
+            value_at(write_pos) = std::move(value_at(read_pos));
+        }
+        else if (policy == Batch_Duplicate_Policy::COMBINE) {
+            value_at(write_pos) = combine(value_at(write_pos), value_at(read_pos));
+        }
+    }
+
+    return write_pos + 1;
+}
+
+template<typename Pair, typename Combine>
+void collapse_sorted_batch(std::vector<Pair>& batch, Batch_Duplicate_Policy policy, Combine combine) {
+    size_t collapsed_size = collapse_sorted_run(batch.size(),
+        [&batch](size_t i) -> typename Pair::first_type& { return batch[i].first; },
+        [&batch](size_t i) -> typename Pair::second_type& { return batch[i].second; }, policy, combine);
+    batch.erase(batch.begin() + collapsed_size, batch.end());
+}
+
+// Applies the policy to a value already in the map, KEEP_OLD leaves it untouched
+template<typename Value, typename Combine>
+void resolve_batch_duplicate(Value& old_value, Value& new_value, Batch_Duplicate_Policy policy, Combine combine) {
+    if (policy == Batch_Duplicate_Policy::OVERWRITE) {
+        old_value = std::move(new_value);
+    }
+    else if (policy == Batch_Duplicate_Policy::COMBINE) {
+        old_value = combine(old_value, new_value);
+    }
+}
+
+/*
+    Keys and values are stored as parallel arrays (structure of arrays), so searches only touch dense key
+    memory and large values never share cache lines with the keys being compared. Iterators pair up the
+    two arrays and hand out {first, second} proxies, like the tree iterators do.
+    Search picks the lookup layout behind find, predecessor and successor (see Flat_Map_Search.h).
+    Binary_Search searches the keys directly, Eytzinger_Search, S_Tree_Search and Learned_Search keep an
+    index that batch operations rebuild, Interpolation_Search and Galloping_Search need no index.
+    std::string keys default to String_Prefix_Search and sort with string_radix_sort (Flat_Map_Key_Sort).
+    Single-key inserts and erases go to a small sorted delta buffer and a tombstone list instead of
+    shifting the arrays, and they are merged in bulk only once they reach the delta limit (or before a
+    batch write). Lookups and iterators read the flat arrays, the delta buffer and the tombstones
+    together, in merged order, so reads never merge and const members never modify the map.
+    Any insert or erase invalidates iterators.
+*/
+template<typename Key, typename Value, typename Search = typename Flat_Map_Default_Search<Key>::type>
 class Radix_Flat_Map{
-    std::vector<std::pair<Key, Value>> radix_flat_map;
+    std::vector<Key> flat_keys;
+    std::vector<Flat_Map_Slot<Value>> flat_values;
+    typename Search::template Index<Key> search_index;
+
+    // sorted keys not in flat_keys, and sorted flat_keys entries erased since the last merge
+    std::vector<Key> delta_keys;
+    std::vector<Flat_Map_Slot<Value>> delta_values;
+    std::vector<Key> tombstones;
+    size_t delta_limit = 0;
+
+    size_t pending_limit() const {
+        if (delta_limit != 0) {
+            return delta_limit;
+        }
+        return std::max(FLAT_MAP_DELTA_MIN, static_cast<size_t>(std::sqrt(static_cast<double>(flat_keys.size()))));
+    }
+
+    bool pending_full() const {
+        return delta_keys.size() + tombstones.size() >= pending_limit();
+    }
+
+    size_t delta_position(const Key& key) const {
+        return flat_map_lower_bound(key, delta_keys.data(), 0, delta_keys.size());
+    }
+
+    size_t tombstone_position(const Key& key) const {
+        return flat_map_lower_bound(key, tombstones.data(), 0, tombstones.size());
+    }
+
+    // Merges new_count sorted keys absent from flat_keys backward into the grown arrays, returns the first position that moved
+    template<typename New_Key, typename New_Value>
+    size_t merge_new_keys(size_t new_count, New_Key new_key, New_Value new_value) {
+        size_t old_pos = flat_keys.size();
+        size_t write_pos = old_pos + new_count;
+        flat_keys.resize(write_pos);
+        flat_values.resize(write_pos);
+        while (new_count > 0) {
+            --write_pos;
+            if (old_pos > 0 and new_key(new_count - 1) < flat_keys[old_pos - 1]) {
+                --old_pos;
+                flat_keys[write_pos] = std::move(flat_keys[old_pos]);
+                flat_values[write_pos] = std::move(flat_values[old_pos]);
+            }
+            else {
+                --new_count;
+                flat_keys[write_pos] = std::move(new_key(new_count));
+                flat_values[write_pos].value = std::move(new_value(new_count));
+            }
+        }
+        return write_pos;
+    }
+
+    // 2-pointer filter over both arrays, returns the first erased position (size if none)
+    size_t erase_sorted_keys(const std::vector<Key>& keys2erase) {
+        size_t first_erased = flat_keys.size();
+        if (keys2erase.empty()) return first_erased;
+
+        size_t write_pos = 0;
+        auto key2erase_iter = keys2erase.begin();
+        for (size_t read_pos = 0; read_pos < flat_keys.size(); ++read_pos) {
+            while (key2erase_iter != keys2erase.end() and *key2erase_iter < flat_keys[read_pos]) {
+                ++key2erase_iter;
+            }
+            if (key2erase_iter != keys2erase.end() and *key2erase_iter == flat_keys[read_pos]) {
+                first_erased = std::min(first_erased, read_pos);
+                ++key2erase_iter;
+                continue;
+            }
+            if (write_pos != read_pos) {
+                flat_keys[write_pos] = std::move(flat_keys[read_pos]);
+                flat_values[write_pos] = std::move(flat_values[read_pos]);
+            }
+            ++write_pos;
+        }
+
+        flat_keys.erase(flat_keys.begin() + write_pos, flat_keys.end());
+        flat_values.erase(flat_values.begin() + write_pos, flat_values.end());
+        return first_erased;
+    }
+
+    // Forward ranges are measured once so the arrays never reallocate (and briefly double) while loading
+    template<typename InputIter>
+    void reserve_batch(InputIter begin, InputIter end, std::forward_iterator_tag) {
+        size_t batch_size = std::distance(begin, end);
+        flat_keys.reserve(batch_size);
+        flat_values.reserve(batch_size);
+    }
+
+    template<typename InputIter>
+    void reserve_batch(InputIter, InputIter, std::input_iterator_tag) {}
+
+    // Bulk load into an empty map: the batch goes straight into the flat arrays and is sorted there
+    template<typename InputIter, typename Combine>
+    void load_empty(InputIter begin, InputIter end, Batch_Duplicate_Policy policy, Combine combine,
+                    size_t thread_count, Radix_Sort_Mode mode) {
+        reserve_batch(begin, end, typename std::iterator_traits<InputIter>::iterator_category());
+        for (; begin != end; ++begin) {
+            flat_keys.emplace_back(begin->first);
+            flat_values.push_back(Flat_Map_Slot<Value>{Value(begin->second)});
+        }
+        Flat_Map_Key_Sort<Key>::sort_by_key(flat_keys.begin(), flat_keys.end(), flat_values.begin(), mode, thread_count);
+        size_t collapsed_size = collapse_sorted_run(flat_keys.size(),
+            [this](size_t i) -> Key& { return flat_keys[i]; },
+            [this](size_t i) -> Value& { return flat_values[i].value; }, policy, combine);
+        flat_keys.erase(flat_keys.begin() + collapsed_size, flat_keys.end());
+        flat_values.erase(flat_values.begin() + collapsed_size, flat_values.end());
+        search_index.rebuild(flat_keys.data(), flat_keys.size(), 0);
+    }
+
+    size_t lower_bound_position(const Key& key) const {
+        return search_index.lower_bound(key, flat_keys.data(), flat_keys.size());
+    }
+
+    size_t upper_bound_position(const Key& key) const {
+        return search_index.upper_bound(key, flat_keys.data(), flat_keys.size());
+    }
+
+    // A position in merged order: the next live flat entry and the next delta entry, whichever key is smaller
+    struct Cursor {
+        size_t flat_pos;    // not tombstoned, or flat_keys.size()
+        size_t tomb_pos;    // tombstones before flat_pos
+        size_t delta_pos;
+    };
+
+    // Moves flat_pos past erased entries, tombstones are flat keys so they line up one by one
+    Cursor skip_erased(Cursor cursor) const {
+        while (cursor.tomb_pos < tombstones.size() and cursor.flat_pos < flat_keys.size()
+               and tombstones[cursor.tomb_pos] == flat_keys[cursor.flat_pos]) {
+            ++cursor.flat_pos;
+            ++cursor.tomb_pos;
+        }
+        return cursor;
+    }
+
+    bool in_delta(const Cursor& cursor) const {
+        return cursor.delta_pos < delta_keys.size()
+               and (cursor.flat_pos == flat_keys.size() or delta_keys[cursor.delta_pos] < flat_keys[cursor.flat_pos]);
+    }
+
+    size_t cursor_rank(const Cursor& cursor) const {
+        return cursor.flat_pos - cursor.tomb_pos + cursor.delta_pos;
+    }
+
+    void advance(Cursor& cursor) const {
+        if (in_delta(cursor)) {
+            ++cursor.delta_pos;
+            return;
+        }
+        ++cursor.flat_pos;
+        cursor = skip_erased(cursor);
+    }
+
+    void retreat(Cursor& cursor) const {
+        // the live flat entry before flat_pos, stepping back over erased ones
+        size_t flat_pos = cursor.flat_pos;
+        size_t tomb_pos = cursor.tomb_pos;
+        while (flat_pos > 0 and tomb_pos > 0 and tombstones[tomb_pos - 1] == flat_keys[flat_pos - 1]) {
+            --flat_pos;
+            --tomb_pos;
+        }
+        if (flat_pos > 0 and (cursor.delta_pos == 0 or delta_keys[cursor.delta_pos - 1] < flat_keys[flat_pos - 1])) {
+            cursor.flat_pos = flat_pos - 1;
+            cursor.tomb_pos = tomb_pos;
+        }
+        else {
+            --cursor.delta_pos;
+        }
+    }
+
+    // First entry >= key (OR_EQUAL false) or > key, given the matching bound in the flat arrays
+    template<bool OR_EQUAL>
+    Cursor bound_cursor(const Key& key, size_t flat_bound) const {
+        return skip_erased(Cursor{flat_bound, flat_map_bound<OR_EQUAL>(key, tombstones.data(), 0, tombstones.size()),
+                                  flat_map_bound<OR_EQUAL>(key, delta_keys.data(), 0, delta_keys.size())});
+    }
+
+    Cursor end_cursor() const {
+        return Cursor{flat_keys.size(), tombstones.size(), delta_keys.size()};
+    }
+
+    /*
+        The entry of a given rank: binary search the delta buffer on the ranks of its keys, then the flat
+        arrays on the number of live entries up to each position. O(log D log N + log^2 N) with pending
+        writes, O(1) without.
+    */
+    Cursor rank_cursor(size_t rank) const {
+        if (rank >= size()) {
+            return end_cursor();
+        }
+        if (tombstones.empty() and delta_keys.empty()) {
+            return Cursor{rank, 0, 0};
+        }
+
+        // delta entries ranked below rank
+        size_t low = 0;
+        size_t high = delta_keys.size();
+        while (low < high) {
+            size_t midpoint = low + (high - low) / 2;
+            const Key& key = delta_keys[midpoint];
+            if (midpoint + lower_bound_position(key) - tombstone_position(key) < rank) {
+                low = midpoint + 1;
+            }
+            else {
+                high = midpoint;
+            }
+        }
+        if (low < delta_keys.size()) {
+            const Key& key = delta_keys[low];
+            if (low + lower_bound_position(key) - tombstone_position(key) == rank) {
+                return bound_cursor<false>(key, lower_bound_position(key));
+            }
+        }
+
+        // the (rank - low)-th live flat entry, the first position with that many live entries before it and itself live
+        size_t live_target = rank - low;
+        size_t flat_low = live_target;
+        size_t flat_high = flat_keys.size();
+        while (flat_low < flat_high) {
+            size_t midpoint = flat_low + (flat_high - flat_low) / 2;
+            size_t live_through = midpoint + 1 - flat_map_upper_bound(flat_keys[midpoint], tombstones.data(), 0, tombstones.size());
+            if (live_through <= live_target) {
+                flat_low = midpoint + 1;
+            }
+            else {
+                flat_high = midpoint;
+            }
+        }
+        return Cursor{flat_low, tombstone_position(flat_keys[flat_low]), low};
+    }
+
     public:
-    using iterator = typename std::vector<std::pair<Key, Value>>::iterator;
-    using const_iterator = typename std::vector<std::pair<Key, Value>>::const_iterator;
+    template<bool IS_CONST>
+    class basic_iterator {
+        using Value_Type = typename std::conditional<IS_CONST, const Value, Value>::type;
+
+        public:
+        // Iterator traits
+        using iterator_category = std::random_access_iterator_tag;
+        using difference_type   = std::ptrdiff_t;
+        using value_type        = std::pair<Key, Value>;
+
+        struct Proxy {
+            const Key& first;
+            Value_Type& second;
+            Proxy(const Key& k, Value_Type& v) : first(k), second(v) {}
+
+            operator std::pair<Key, Value>() const {
+                return std::pair<Key, Value>(first, second);
+            }
+        };
+
+        struct ArrowProxy {
+            Proxy p;
+            Proxy* operator->() { return &p; }
+        };
+
+        using reference = Proxy;
+        using pointer   = ArrowProxy;
+
+        private:
+        using Map_Pointer = typename std::conditional<IS_CONST, const Radix_Flat_Map*, Radix_Flat_Map*>::type;
+
+        Map_Pointer map;
+        Cursor cursor;
+
+        basic_iterator(Map_Pointer map, Cursor cursor) : map(map), cursor(cursor) {}
+
+        difference_type rank() const {
+            return static_cast<difference_type>(map->cursor_rank(cursor));
+        }
+
+        friend class Radix_Flat_Map;
+        template<bool> friend class basic_iterator;
+
+        public:
+        basic_iterator() : map(nullptr), cursor{0, 0, 0} {}
+
+        // Converting constructor from non-const iterator
+        template<bool OTHER_CONST, typename = std::enable_if_t<IS_CONST and not OTHER_CONST>>
+        basic_iterator(const basic_iterator<OTHER_CONST>& other) : map(other.map), cursor(other.cursor) {}
+
+        Proxy operator*() const {
+            if (map->in_delta(cursor)) {
+                return Proxy(map->delta_keys[cursor.delta_pos], map->delta_values[cursor.delta_pos].value);
+            }
+            return Proxy(map->flat_keys[cursor.flat_pos], map->flat_values[cursor.flat_pos].value);
+        }
+
+        ArrowProxy operator->() const {
+            return ArrowProxy{ **this };
+        }
+
+        Proxy operator[](difference_type n) const {
+            return *(*this + n);
+        }
+
+        basic_iterator& operator++() { map->advance(cursor); return *this; }
+        basic_iterator operator++(int) { basic_iterator old = *this; ++(*this); return old; }
+        basic_iterator& operator--() { map->retreat(cursor); return *this; }
+        basic_iterator operator--(int) { basic_iterator old = *this; --(*this); return old; }
+
+        // Jumps go through the rank, O(1) when nothing is pending
+        basic_iterator& operator+=(difference_type n) { cursor = map->rank_cursor(rank() + n); return *this; }
+        basic_iterator& operator-=(difference_type n) { return *this += -n; }
+        basic_iterator operator+(difference_type n) const { basic_iterator it = *this; return it += n; }
+        basic_iterator operator-(difference_type n) const { basic_iterator it = *this; return it -= n; }
+        friend basic_iterator operator+(difference_type n, const basic_iterator& it) { return it + n; }
+
+        // Comparison operators, mixed const-nonconst through the rank; tomb_pos follows from flat_pos
+        template<bool OTHER_CONST>
+        difference_type operator-(const basic_iterator<OTHER_CONST>& other) const { return rank() - other.rank(); }
+        template<bool OTHER_CONST>
+        bool operator==(const basic_iterator<OTHER_CONST>& other) const {
+            return cursor.flat_pos == other.cursor.flat_pos and cursor.delta_pos == other.cursor.delta_pos;
+        }
+        template<bool OTHER_CONST>
+        bool operator!=(const basic_iterator<OTHER_CONST>& other) const { return not (*this == other); }
+        template<bool OTHER_CONST>
+        bool operator<(const basic_iterator<OTHER_CONST>& other) const { return rank() < other.rank(); }
+        template<bool OTHER_CONST>
+        bool operator>(const basic_iterator<OTHER_CONST>& other) const { return rank() > other.rank(); }
+        template<bool OTHER_CONST>
+        bool operator<=(const basic_iterator<OTHER_CONST>& other) const { return rank() <= other.rank(); }
+        template<bool OTHER_CONST>
+        bool operator>=(const basic_iterator<OTHER_CONST>& other) const { return rank() >= other.rank(); }
+    };
+
+    using iterator = basic_iterator<false>;
+    using const_iterator = basic_iterator<true>;
 
     Radix_Flat_Map() = default;
 
+    // The range is sorted inside the flat arrays: MSD_IN_PLACE allocates nothing else, the LSD modes
+    // sort (key bits, index) tuples, with parallel_radix_sort when thread_count > 1
     template<typename input_iterator>
-    explicit Radix_Flat_Map(input_iterator begin, input_iterator end)
-    : radix_flat_map(begin, end){
-        radix_sort(radix_flat_map.begin(),radix_flat_map.end(), [](const auto& p) { return p.first; });
-        remove_duplicates(radix_flat_map, [](const auto& p) { return p.first; });
+    explicit Radix_Flat_Map(input_iterator begin, input_iterator end, size_t thread_count = 1,
+                            Radix_Sort_Mode mode = Radix_Sort_Mode::LSD_BUFFERED) {
+        insert_batch(begin, end, thread_count, mode);
+    }
+
+    // Batch operations rebuild the index from the first position they changed, this rebuilds all of it
+    void rebuild_search_index() {
+        flush_pending();
+        search_index.rebuild(flat_keys.data(), flat_keys.size(), 0);
+    }
+
+    // Merges the delta buffer and tombstones into the flat arrays, O(N + B)
+    void flush_pending() {
+        if (delta_keys.empty() and tombstones.empty()) return;
+
+        size_t first_changed = erase_sorted_keys(tombstones);
+        first_changed = std::min(first_changed, merge_new_keys(delta_keys.size(),
+            [this](size_t i) -> Key& { return delta_keys[i]; },
+            [this](size_t i) -> Value& { return delta_values[i].value; }));
+        delta_keys.clear();
+        delta_values.clear();
+        tombstones.clear();
+        search_index.rebuild(flat_keys.data(), flat_keys.size(), first_changed);
+    }
+
+    // Pending single-key writes allowed before a merge, 0 picks max(FLAT_MAP_DELTA_MIN, sqrt(size))
+    void set_delta_limit(size_t limit) {
+        delta_limit = limit;
+    }
+
+    // The layout's own statistics (memory, model error) for tuning
+    const typename Search::template Index<Key>& search_layout() const {
+        return search_index;
     }
 
     template<typename AnyVector, typename Getter>
@@ -43,47 +518,42 @@ class Radix_Flat_Map{
         vec2remdups.erase(write_pos + 1, vec2remdups.end());
     }
 
-    size_t lower_bound_binary_search(const Key& key2find) {
-        /* same as upper bound binary search except at if(key2find > radix_flat_map[midpoint].first){ */
-        size_t low = 0;
-        size_t high = radix_flat_map.size();
-        while(low < high){
-            size_t midpoint = low + (high - low) / 2;
-            if(key2find > radix_flat_map[midpoint].first){
-                low = midpoint + 1;
-            }
-            else{
-                high = midpoint;
-            }
-        }
-        return low;
+    // Sorted positions (ranks) counting the pending writes
+    size_t lower_bound_binary_search(const Key& key2find) const {
+        return flat_map_lower_bound(key2find, flat_keys.data(), 0, flat_keys.size())
+               - tombstone_position(key2find) + delta_position(key2find);
     }
 
-    size_t upper_bound_binary_search(const Key& key2find) {
-        /* same as lower bound binary search except at if(key2find >= radix_flat_map[midpoint].first){ */
-        size_t low = 0;
-        size_t high = radix_flat_map.size();
-        while(low < high){
-            size_t midpoint = low + (high - low) / 2;
-            if(key2find >= radix_flat_map[midpoint].first){
-                low = midpoint + 1;
-            }
-            else{
-                high = midpoint;
-            }
-        }
-        return low;
+    size_t upper_bound_binary_search(const Key& key2find) const {
+        return flat_map_upper_bound(key2find, flat_keys.data(), 0, flat_keys.size())
+               - flat_map_upper_bound(key2find, tombstones.data(), 0, tombstones.size())
+               + flat_map_upper_bound(key2find, delta_keys.data(), 0, delta_keys.size());
     }
 
+    // The reference stays valid until the next insert or erase, which may merge the delta buffer
     Value& operator[](const Key& key) {
-        size_t pos = lower_bound_binary_search(key);
+        size_t pos = lower_bound_position(key);
 
-        if (pos < radix_flat_map.size() and radix_flat_map[pos].first == key) {
-            return radix_flat_map[pos].second;
+        if (pos < flat_keys.size() and flat_keys[pos] == key) {
+            size_t tombstone_pos = tombstone_position(key);
+            if (tombstone_pos < tombstones.size() and tombstones[tombstone_pos] == key) {
+                tombstones.erase(tombstones.begin() + tombstone_pos);
+                flat_values[pos].value = Value{};
+            }
+            return flat_values[pos].value;
         }
 
-        auto it = radix_flat_map.emplace(radix_flat_map.begin() + pos, key, Value{});
-        return it->second;
+        size_t delta_pos = delta_position(key);
+        if (delta_pos < delta_keys.size() and delta_keys[delta_pos] == key) {
+            return delta_values[delta_pos].value;
+        }
+
+        if (pending_full()) {
+            flush_pending();
+            return (*this)[key];
+        }
+        delta_keys.insert(delta_keys.begin() + delta_pos, key);
+        return delta_values.emplace(delta_values.begin() + delta_pos)->value;
     }
 
     bool insert(const std::pair<Key, Value>& map_pair) {
@@ -91,147 +561,383 @@ class Radix_Flat_Map{
     }
 
     bool insert(const Key& key, const Value& value){
-        size_t pos = lower_bound_binary_search(key);
+        size_t pos = lower_bound_position(key);
+
+        //check if duplicate key, an erased key that is still in the arrays comes back in place
+        if(pos < flat_keys.size() and key == flat_keys[pos]) {
+            size_t tombstone_pos = tombstone_position(key);
+            if (tombstone_pos < tombstones.size() and tombstones[tombstone_pos] == key) {
+                tombstones.erase(tombstones.begin() + tombstone_pos);
+                flat_values[pos].value = value;
+                return true;
+            }
+            return false;
+        }
 
-        //check if duplicate key
-        if(pos < radix_flat_map.size() and key == radix_flat_map[pos].first) {
+        size_t delta_pos = delta_position(key);
+        if (delta_pos < delta_keys.size() and delta_keys[delta_pos] == key) {
             return false;
         }
 
-        //emplace (insert but more efficient) at position
-        radix_flat_map.emplace(radix_flat_map.begin() + pos, key, value);
+        //insert into the delta buffer, merging it first when full
+        if (pending_full()) {
+            flush_pending();
+            return insert(key, value);
+        }
+        delta_keys.insert(delta_keys.begin() + delta_pos, key);
+        delta_values.insert(delta_values.begin() + delta_pos, Flat_Map_Slot<Value>{value});
         return true;
     }
 
     bool erase(const Key& key){
-        size_t pos = lower_bound_binary_search(key);
+        size_t delta_pos = delta_position(key);
+        if (delta_pos < delta_keys.size() and delta_keys[delta_pos] == key) {
+            delta_keys.erase(delta_keys.begin() + delta_pos);
+            delta_values.erase(delta_values.begin() + delta_pos);
+            return true;
+        }
+
+        size_t pos = lower_bound_position(key);
 
-        //check if key doesn't exist
-        if(pos >= radix_flat_map.size() or key != radix_flat_map[pos].first) {
+        //check if key doesn't exist or is already erased
+        if(pos >= flat_keys.size() or key != flat_keys[pos]) {
+            return false;
+        }
+        size_t tombstone_pos = tombstone_position(key);
+        if (tombstone_pos < tombstones.size() and tombstones[tombstone_pos] == key) {
             return false;
         }
 
-        radix_flat_map.erase(radix_flat_map.begin() + pos);
+        if (pending_full()) {
+            flush_pending();
+            return erase(key);
+        }
+        tombstones.insert(tombstones.begin() + tombstone_pos, key);
         return true;
     }
 
     iterator find(const Key& key) {
-        size_t pos = lower_bound_binary_search(key);
-        if (pos < radix_flat_map.size() and radix_flat_map[pos].first == key) {
-            return radix_flat_map.begin() + pos;
-        }
-        return this->end();
+        return iterator_at(found_cursor(key, lower_bound_position(key)));
     }
 
     iterator predecessor(const Key& key){
-        size_t pos = lower_bound_binary_search(key);
+        return iterator_at(predecessor_cursor(bound_cursor<false>(key, lower_bound_position(key))));
+    }
+
+    iterator successor(const Key& key){
+        return iterator_at(bound_cursor<true>(key, upper_bound_position(key)));
+    }
+
+    const_iterator find(const Key& key) const {
+        return iterator_at(found_cursor(key, lower_bound_position(key)));
+    }
+
+    const_iterator predecessor(const Key& key) const {
+        return iterator_at(predecessor_cursor(bound_cursor<false>(key, lower_bound_position(key))));
+    }
+
+    const_iterator successor(const Key& key) const {
+        return iterator_at(bound_cursor<true>(key, upper_bound_position(key)));
+    }
 
-        //no predecessor
-        if(pos == 0) {
-            return this->end();
+    private:
+    iterator iterator_at(const Cursor& cursor) {
+        return iterator(this, cursor);
+    }
+
+    const_iterator iterator_at(const Cursor& cursor) const {
+        return const_iterator(this, cursor);
+    }
+
+    // The entry holding key, or the end cursor
+    Cursor found_cursor(const Key& key, size_t flat_bound) const {
+        Cursor cursor = bound_cursor<false>(key, flat_bound);
+        if (cursor_rank(cursor) < size() and (*const_iterator(this, cursor)).first == key) {
+            return cursor;
         }
+        return end_cursor();
+    }
 
-        return radix_flat_map.begin() + (pos - 1);
+    // The entry before a lower bound, the end cursor when there is none
+    Cursor predecessor_cursor(Cursor cursor) const {
+        if (cursor_rank(cursor) == 0) {
+            return end_cursor();
+        }
+        retreat(cursor);
+        return cursor;
     }
 
-    iterator successor(const Key& key){
-         size_t pos = upper_bound_binary_search(key);
+    // Lower (OR_EQUAL false) or upper bound of every probe, in probe order
+    template<bool OR_EQUAL>
+    std::vector<Cursor> batch_bound_cursors(const std::vector<Key>& keys) const {
+        std::vector<std::pair<Key, size_t>> probes;
+        probes.reserve(keys.size());
+        for (size_t i = 0; i < keys.size(); ++i) {
+            probes.emplace_back(keys[i], i);
+        }
+        Flat_Map_Key_Sort<Key>::sort(probes.begin(), probes.end(), [](const std::pair<Key, size_t>& probe) -> const Key& { return probe.first; });
+
+        // each of the three sorted runs gallops from the previous answer
+        std::vector<Cursor> cursors(keys.size());
+        Cursor hint{0, 0, 0};
+        for (const auto& probe : probes) {
+            hint.flat_pos = flat_map_gallop<OR_EQUAL>(probe.first, flat_keys.data(), flat_keys.size(), hint.flat_pos);
+            hint.tomb_pos = flat_map_gallop<OR_EQUAL>(probe.first, tombstones.data(), tombstones.size(), hint.tomb_pos);
+            hint.delta_pos = flat_map_gallop<OR_EQUAL>(probe.first, delta_keys.data(), delta_keys.size(), hint.delta_pos);
+            cursors[probe.second] = skip_erased(hint);
+        }
+        return cursors;
+    }
+
+    public:
+    // Hinted lookups gallop outward from hint in the flat arrays, O(log distance) when the answer is near it
+    iterator find(const Key& key, const_iterator hint) {
+        return iterator_at(found_cursor(key, flat_map_gallop<false>(key, flat_keys.data(), flat_keys.size(), hint.cursor.flat_pos)));
+    }
+
+    iterator predecessor(const Key& key, const_iterator hint) {
+        size_t flat_bound = flat_map_gallop<false>(key, flat_keys.data(), flat_keys.size(), hint.cursor.flat_pos);
+        return iterator_at(predecessor_cursor(bound_cursor<false>(key, flat_bound)));
+    }
+
+    iterator successor(const Key& key, const_iterator hint) {
+        size_t flat_bound = flat_map_gallop<true>(key, flat_keys.data(), flat_keys.size(), hint.cursor.flat_pos);
+        return iterator_at(bound_cursor<true>(key, flat_bound));
+    }
+
+    /*
+        Batch lookups radix sort the probes (remembering where each came from), then walk the keys once,
+        galloping from each answer to the next, so thousands of probes share cache lines and cost
+        O(P log(N / P)) comparisons. Results come back in the caller's probe order.
+    */
+    std::vector<iterator> batch_find(const std::vector<Key>& keys) {
+        std::vector<Cursor> cursors = batch_bound_cursors<false>(keys);
+        std::vector<iterator> results;
+        results.reserve(keys.size());
+        for (size_t i = 0; i < keys.size(); ++i) {
+            iterator it = iterator_at(cursors[i]);
+            bool found = cursor_rank(cursors[i]) < size() and (*it).first == keys[i];
+            results.push_back(found ? it : this->end());
+        }
+        return results;
+    }
+
+    std::vector<iterator> batch_predecessors(const std::vector<Key>& keys) {
+        std::vector<Cursor> cursors = batch_bound_cursors<false>(keys);
+        std::vector<iterator> results;
+        results.reserve(keys.size());
+        for (const Cursor& cursor : cursors) {
+            results.push_back(iterator_at(predecessor_cursor(cursor)));
+        }
+        return results;
+    }
 
-        //no successor
-        if(pos >= radix_flat_map.size()) {
-            return this->end();
+    std::vector<iterator> batch_successors(const std::vector<Key>& keys) {
+        std::vector<Cursor> cursors = batch_bound_cursors<true>(keys);
+        std::vector<iterator> results;
+        results.reserve(keys.size());
+        for (const Cursor& cursor : cursors) {
+            results.push_back(iterator_at(cursor));
+        }
+        return results;
+    }
+
+    private:
+    // Shared by the const and non-const range_for_each, a plain slice loop when nothing is pending
+    template<typename Map, typename Function>
+    static void for_each_in_range(Map& map, const Key& lo, const Key& hi, Function& f) {
+        if (hi < lo) return;
+        size_t first = map.lower_bound_position(lo);
+        size_t last = map.upper_bound_position(hi);
+        if (map.tombstones.empty() and map.delta_keys.empty()) {
+            for (size_t pos = first; pos < last; ++pos) {
+                f(map.flat_keys[pos], map.flat_values[pos].value);
+            }
+            return;
+        }
+        auto stop = map.iterator_at(map.template bound_cursor<true>(hi, last));
+        for (auto it = map.iterator_at(map.template bound_cursor<false>(lo, first)); it != stop; ++it) {
+            auto entry = *it;
+            f(entry.first, entry.second);
         }
+    }
+
+    public:
+    /*
+        Range queries cover the inclusive key range [lo, hi] (empty when hi < lo). Without pending writes
+        the range is one contiguous slice of the flat arrays, so it costs two bound searches plus a linear
+        pass over the slice; otherwise the pass merges in the delta buffer and skips tombstones.
+        range_count needs only the searches.
+    */
+    template<typename Function>
+    void range_for_each(const Key& lo, const Key& hi, Function f) {
+        for_each_in_range(*this, lo, hi, f);
+    }
+
+    template<typename Function>
+    void range_for_each(const Key& lo, const Key& hi, Function f) const {
+        for_each_in_range(*this, lo, hi, f);
+    }
+
+    size_t range_count(const Key& lo, const Key& hi) const {
+        if (hi < lo) return 0;
+        size_t flat_count = upper_bound_position(hi) - lower_bound_position(lo);
+        size_t erased = flat_map_upper_bound(hi, tombstones.data(), 0, tombstones.size()) - tombstone_position(lo);
+        size_t added = flat_map_upper_bound(hi, delta_keys.data(), 0, delta_keys.size()) - delta_position(lo);
+        return flat_count - erased + added;
+    }
+
+    // Sum of the values in [lo, hi] starting from Value{}
+    Value range_sum(const Key& lo, const Key& hi) const {
+        Value sum{};
+        range_for_each(lo, hi, [&sum](const Key&, const Value& value) { sum += value; });
+        return sum;
+    }
+
+    // Order statistics by index arithmetic: rank counts pending writes without merging them
+    size_t rank(const Key& key) const {
+        return lower_bound_position(key) - tombstone_position(key) + delta_position(key);
+    }
+
+    // The k-th smallest entry (0-based), end() when k >= size()
+    iterator select(size_t k) {
+        return iterator_at(rank_cursor(k));
+    }
 
-        return radix_flat_map.begin() + pos;
+    const_iterator select(size_t k) const {
+        return iterator_at(rank_cursor(k));
     }
 
     void reserve(const size_t N) {
-        radix_flat_map.reserve(N);
+        flat_keys.reserve(N);
+        flat_values.reserve(N);
     }
 
     size_t size() const noexcept {
-        return radix_flat_map.size();
+        return flat_keys.size() - tombstones.size() + delta_keys.size();
     }
 
     size_t max_size() const noexcept {
         return std::numeric_limits<std::ptrdiff_t>::max();
     }
 
+    // Answers from the flat arrays plus the pending writes, without merging them
     size_t count(const Key& key) const{
-        if(this->find(key) != this->end()){
-            return 1;
+        size_t pos = lower_bound_position(key);
+        if(pos < flat_keys.size() and flat_keys[pos] == key){
+            size_t tombstone_pos = tombstone_position(key);
+            return tombstone_pos < tombstones.size() and tombstones[tombstone_pos] == key ? 0 : 1;
         }
-        return 0;
+        size_t delta_pos = delta_position(key);
+        return delta_pos < delta_keys.size() and delta_keys[delta_pos] == key ? 1 : 0;
     }
 
+    /*
+        Batch writes sort only the batch and merge it into the map: keys already present are resolved in
+        place, the arrays grow once by the number of new keys and both sorted runs are merged from the back,
+        so the cost is sorting B plus O(N + B) moves instead of re-sorting N + B. An empty map skips the
+        batch copy and sorts the batch inside its own arrays.
+        Repeats inside the batch follow the same policy in batch order (unspecified order for MSD_IN_PLACE and std::string keys).
+    */
     template<typename InputIter>
-    void insert_batch(InputIter begin, InputIter end) {
-        radix_flat_map.insert(radix_flat_map.end(), begin, end);
-        radix_sort(radix_flat_map.begin(),radix_flat_map.end(), [](const auto& p) { return p.first; });
-        remove_duplicates(radix_flat_map, [](const auto& p) { return p.first; });
+    void insert_batch(InputIter begin, InputIter end, size_t thread_count = 1,
+                      Radix_Sort_Mode mode = Radix_Sort_Mode::LSD_BUFFERED) {
+        merge_batch(begin, end, Batch_Duplicate_Policy::KEEP_OLD,
+                    [](const Value& old_value, const Value&) { return old_value; }, thread_count, mode);
     }
 
     template<typename InputIter>
-    void erase_batch(InputIter begin, InputIter end) {
-        std::vector<Key> keys2erase(begin, end);
-        radix_sort(keys2erase.begin(),keys2erase.end(), [](const Key& key) { return key; });
-        remove_duplicates(keys2erase, [](const Key& key) { return key; });
+    void insert_or_assign_batch(InputIter begin, InputIter end, size_t thread_count = 1,
+                                Radix_Sort_Mode mode = Radix_Sort_Mode::LSD_BUFFERED) {
+        merge_batch(begin, end, Batch_Duplicate_Policy::OVERWRITE,
+                    [](const Value&, const Value& new_value) { return new_value; }, thread_count, mode);
+    }
 
-        //Perform the 2-pointer filter algorithm
-        auto read_iter = radix_flat_map.begin();
-        auto write_iter = radix_flat_map.begin();
-        auto key2erase_iter = keys2erase.begin();
+    // combine(old_value, new_value) returns the value kept for a key in both the map and the batch
+    template<typename InputIter, typename Combine>
+    void merge_batch(InputIter begin, InputIter end, Combine combine, size_t thread_count = 1,
+                     Radix_Sort_Mode mode = Radix_Sort_Mode::LSD_BUFFERED) {
+        merge_batch(begin, end, Batch_Duplicate_Policy::COMBINE, combine, thread_count, mode);
+    }
 
-        while (read_iter != radix_flat_map.end()) {
-            if (key2erase_iter == keys2erase.end()) {
-                if (write_iter != read_iter) {
-                    *write_iter = std::move(*read_iter);
-                }
-                ++write_iter;
-                ++read_iter;
-            }
-            else if (read_iter->first < *key2erase_iter) {
-                if (write_iter != read_iter) {
-                    *write_iter = std::move(*read_iter);
-                }
-                ++write_iter;
-                ++read_iter;
+    template<typename InputIter, typename Combine>
+    void merge_batch(InputIter begin, InputIter end, Batch_Duplicate_Policy policy, Combine combine,
+                     size_t thread_count = 1, Radix_Sort_Mode mode = Radix_Sort_Mode::LSD_BUFFERED) {
+        if (begin == end) return;
+        flush_pending();
+        if (flat_keys.empty()) {
+            load_empty(begin, end, policy, combine, thread_count, mode);
+            return;
+        }
+
+        std::vector<std::pair<Key, Value>> batch(begin, end);
+        Flat_Map_Key_Sort<Key>::sort(batch.begin(), batch.end(), [](const std::pair<Key, Value>& p) -> const Key& { return p.first; },
+                                     mode, thread_count);
+        collapse_sorted_batch(batch, policy, combine);
+
+        //resolve keys the map already has, compact the new ones to the front of batch
+        size_t new_count = 0;
+        size_t map_pos = lower_bound_position(batch.front().first);
+        for (size_t batch_pos = 0; batch_pos < batch.size(); ++batch_pos) {
+            while (map_pos < flat_keys.size() and flat_keys[map_pos] < batch[batch_pos].first) {
+                ++map_pos;
             }
-            else if (read_iter->first == *key2erase_iter) {
-                ++read_iter;
-                ++key2erase_iter;
+            if (map_pos < flat_keys.size() and flat_keys[map_pos] == batch[batch_pos].first) {
+                resolve_batch_duplicate(flat_values[map_pos].value, batch[batch_pos].second, policy, combine);
+                continue;
             }
-            else {
-                ++key2erase_iter;
+            if (new_count != batch_pos) {
+                batch[new_count] = std::move(batch[batch_pos]);
             }
+            ++new_count;
         }
+        if (new_count == 0) return;
+
+        //backward merge into the grown arrays, old keys below the smallest new key never move
+        size_t first_changed = merge_new_keys(new_count,
+            [&batch](size_t i) -> Key& { return batch[i].first; },
+            [&batch](size_t i) -> Value& { return batch[i].second; });
+        search_index.rebuild(flat_keys.data(), flat_keys.size(), first_changed);
+    }
 
-        radix_flat_map.erase(write_iter, radix_flat_map.end());
+    template<typename InputIter>
+    void erase_batch(InputIter begin, InputIter end) {
+        std::vector<Key> keys2erase(begin, end);
+        Flat_Map_Key_Sort<Key>::sort(keys2erase.begin(), keys2erase.end(), [](const Key& key) -> const Key& { return key; });
+        remove_duplicates(keys2erase, [](const Key& key) -> const Key& { return key; });
+
+        flush_pending();
+        size_t old_size = flat_keys.size();
+        size_t first_erased = erase_sorted_keys(keys2erase);
+        if (flat_keys.size() != old_size) {
+            search_index.rebuild(flat_keys.data(), flat_keys.size(), first_erased);
+        }
     }
 
-    // Iterator methods
+    // Iterator methods, iterators walk the flat arrays and the pending writes in merged order
     iterator begin() {
-        return radix_flat_map.begin();
+        return iterator_at(skip_erased(Cursor{0, 0, 0}));
     }
 
     iterator end() {
-        return radix_flat_map.end();
+        return iterator_at(end_cursor());
     }
 
     const_iterator begin() const {
-        return radix_flat_map.begin();
+        return iterator_at(skip_erased(Cursor{0, 0, 0}));
     }
 
     const_iterator end() const {
-        return radix_flat_map.end();
+        return iterator_at(end_cursor());
     }
 
     const_iterator cbegin() const {
-        return radix_flat_map.cbegin();
+        return this->begin();
     }
 
     const_iterator cend() const {
-        return radix_flat_map.cend();
+        return this->end();
     }
 };
+
 #endif //RADIX_FLAT_MAP_H
@@ -1,12 +1,240 @@
 #ifndef RADIX_SORT_H
 #define RADIX_SORT_H
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <vector>
 #include <iterator>
+#include <limits>
+#include <string>
+#include <thread>
+#include <tuple>
 #include <type_traits>
+#include <utility>
+
+/*
+    Digit widths accepted by every radix_sort overload (pass as the first template argument):
+        8 bits  -> 256 buckets,   a 64-bit key takes 8 passes (default)
+        11 bits -> 2048 buckets,  a 64-bit key takes 6 passes
+        16 bits -> 65536 buckets, a 64-bit key takes 4 passes
+    e.g. radix_sort<16>(vec.begin(), vec.end(), getter);
+*/
+template <size_t DIGIT_BITS>
+struct Radix_Digit_Check {
+    static_assert(DIGIT_BITS == 8 or DIGIT_BITS == 11 or DIGIT_BITS == 16,
+        "Radix sort digit width must be 8, 11 or 16 bits.");
+    static constexpr size_t bucket_count = size_t(1) << DIGIT_BITS;
+};
+
+/*
+    Radix_Key_Traits<Key> maps a key onto unsigned "key bits" whose unsigned order matches the key order:
+        Bits          unsigned integer (or Radix_Wide_Bits for keys wider than 64 bits) holding the key bits
+        bit_count     number of meaningful bits, which decides how many digit passes are needed
+        to_bits(key)  the order-preserving transform
+    Built in: integers, float, double, 128-bit integers, std::pair and std::tuple (lexicographic).
+    Specialize it to radix sort any other key type.
+*/
+template <typename Key, typename Enable = void>
+struct Radix_Key_Traits {
+    static_assert(sizeof(Key) == 0,
+        "Radix sort has no Radix_Key_Traits for this key type. "
+        "Provide a getter that returns a supported key or specialize Radix_Key_Traits.");
+};
+
+// Multi-word key bits, words[0] is the least significant word
+template <size_t WORDS>
+struct Radix_Wide_Bits {
+    uint64_t words[WORDS] = {};
+
+    bool operator<(const Radix_Wide_Bits& other) const {
+        for (size_t i = WORDS; i > 0; --i) {
+            if (words[i - 1] != other.words[i - 1]) return words[i - 1] < other.words[i - 1];
+        }
+        return false;
+    }
+
+    bool operator==(const Radix_Wide_Bits& other) const {
+        return std::equal(words, words + WORDS, other.words);
+    }
+};
+
+// Smallest bits type able to hold bit_count bits
+template <size_t bit_count>
+using Radix_Bits_For = std::conditional_t<(bit_count <= 64), uint64_t, Radix_Wide_Bits<(bit_count + 63) / 64>>;
+
+// Extracts the digit starting at bit shift
+template <typename Bits>
+size_t radix_digit(const Bits& bits, size_t shift, size_t digit_mask) {
+    return static_cast<size_t>(bits >> shift) & digit_mask;
+}
+
+template <size_t WORDS>
+size_t radix_digit(const Radix_Wide_Bits<WORDS>& bits, size_t shift, size_t digit_mask) {
+    size_t word = shift / 64;
+    size_t offset = shift % 64;
+    if (word >= WORDS) return 0;
+    uint64_t digit = bits.words[word] >> offset;
+    // The digit straddles two words
+    if (offset != 0 and word + 1 < WORDS) {
+        digit |= bits.words[word + 1] << (64 - offset);
+    }
+    return static_cast<size_t>(digit) & digit_mask;
+}
+
+// ORs part (at most 64 meaningful bits, or a wide value) into bits starting at bit offset
+inline void radix_deposit(uint64_t& bits, uint64_t part, size_t offset) {
+    bits |= part << offset;
+}
+
+template <size_t WORDS>
+void radix_deposit(Radix_Wide_Bits<WORDS>& bits, uint64_t part, size_t offset) {
+    size_t word = offset / 64;
+    size_t shift = offset % 64;
+    if (word < WORDS) bits.words[word] |= part << shift;
+    if (shift != 0 and word + 1 < WORDS) bits.words[word + 1] |= part >> (64 - shift);
+}
+
+template <size_t WORDS, size_t PART_WORDS>
+void radix_deposit(Radix_Wide_Bits<WORDS>& bits, const Radix_Wide_Bits<PART_WORDS>& part, size_t offset) {
+    for (size_t i = 0; i < PART_WORDS; ++i) {
+        radix_deposit(bits, part.words[i], offset + i * 64);
+    }
+}
+
+// Integers: flip the sign bit so negative numbers order before positive ones
+template <typename Key>
+struct Radix_Key_Traits<Key, std::enable_if_t<std::is_integral<Key>::value and !std::is_same<Key, bool>::value
+                                              and (sizeof(Key) <= 8)>> {
+    using Bits = std::make_unsigned_t<Key>;
+    static constexpr size_t bit_count = sizeof(Key) * 8;
+
+    static Bits to_bits(const Key& key) {
+        constexpr Bits SIGN_BIT_MASK = std::is_signed<Key>::value
+            ? (Bits(1) << (sizeof(Key) * 8 - 1))
+            : 0;
+        return static_cast<Bits>(key) ^ SIGN_BIT_MASK;
+    }
+};
+
+// IEEE-754: flip every bit of negative numbers, only the sign bit of positive ones
+template <typename Float, typename Bits_Type>
+struct Radix_Float_Key_Traits {
+    static_assert(sizeof(Float) == sizeof(Bits_Type) and std::numeric_limits<Float>::is_iec559,
+        "Radix sort only supports IEEE-754 floating-point keys.");
+    using Bits = Bits_Type;
+    static constexpr size_t bit_count = sizeof(Float) * 8;
+
+    static Bits to_bits(const Float& key) {
+        constexpr Bits SIGN_BIT_MASK = Bits(1) << (bit_count - 1);
+        Bits bits;
+        std::memcpy(&bits, &key, sizeof(Float));
+        return (bits & SIGN_BIT_MASK) ? static_cast<Bits>(~bits) : static_cast<Bits>(bits ^ SIGN_BIT_MASK);
+    }
+};
+
+template <>
+struct Radix_Key_Traits<float> : Radix_Float_Key_Traits<float, uint32_t> {};
+
+template <>
+struct Radix_Key_Traits<double> : Radix_Float_Key_Traits<double, uint64_t> {};
+
+#ifdef __SIZEOF_INT128__
+// 128-bit integers are split into two 64-bit words and sorted with multi-word passes
+template <>
+struct Radix_Key_Traits<unsigned __int128> {
+    using Bits = Radix_Wide_Bits<2>;
+    static constexpr size_t bit_count = 128;
+
+    static Bits to_bits(const unsigned __int128& key) {
+        Bits bits;
+        bits.words[0] = static_cast<uint64_t>(key);
+        bits.words[1] = static_cast<uint64_t>(key >> 64);
+        return bits;
+    }
+};
+
+template <>
+struct Radix_Key_Traits<__int128> {
+    using Bits = Radix_Wide_Bits<2>;
+    static constexpr size_t bit_count = 128;
+
+    static Bits to_bits(const __int128& key) {
+        Bits bits = Radix_Key_Traits<unsigned __int128>::to_bits(static_cast<unsigned __int128>(key));
+        bits.words[1] ^= uint64_t(1) << 63;
+        return bits;
+    }
+};
+#endif
+
+// Key bits sort as themselves (used by indirect_radix_sort on wide keys)
+template <size_t WORDS>
+struct Radix_Key_Traits<Radix_Wide_Bits<WORDS>> {
+    using Bits = Radix_Wide_Bits<WORDS>;
+    static constexpr size_t bit_count = WORDS * 64;
+
+    static Bits to_bits(const Bits& key) {
+        return key;
+    }
+};
+
+// Number of key bits taken by tuple elements I..end
+template <typename Tuple, size_t I, size_t N = std::tuple_size<Tuple>::value>
+struct Radix_Tuple_Bit_Count {
+    static constexpr size_t value =
+        Radix_Key_Traits<std::decay_t<std::tuple_element_t<I, Tuple>>>::bit_count
+        + Radix_Tuple_Bit_Count<Tuple, I + 1, N>::value;
+};
+
+template <typename Tuple, size_t N>
+struct Radix_Tuple_Bit_Count<Tuple, N, N> {
+    static constexpr size_t value = 0;
+};
+
+// Packs element I above all later elements so the first element is the most significant
+template <typename Tuple, size_t I, size_t N = std::tuple_size<Tuple>::value>
+struct Radix_Tuple_Packer {
+    template <typename Bits>
+    static void pack(Bits& bits, const Tuple& key) {
+        using Element = std::decay_t<std::tuple_element_t<I, Tuple>>;
+        radix_deposit(bits, Radix_Key_Traits<Element>::to_bits(std::get<I>(key)),
+                      Radix_Tuple_Bit_Count<Tuple, I + 1, N>::value);
+        Radix_Tuple_Packer<Tuple, I + 1, N>::pack(bits, key);
+    }
+};
+
+template <typename Tuple, size_t N>
+struct Radix_Tuple_Packer<Tuple, N, N> {
+    template <typename Bits>
+    static void pack(Bits&, const Tuple&) {}
+};
+
+// Composite keys sort lexicographically, element by element
+template <typename Tuple>
+struct Radix_Tuple_Key_Traits {
+    static constexpr size_t bit_count = Radix_Tuple_Bit_Count<Tuple, 0>::value;
+    using Bits = Radix_Bits_For<bit_count>;
+
+    static Bits to_bits(const Tuple& key) {
+        Bits bits{};
+        Radix_Tuple_Packer<Tuple, 0>::pack(bits, key);
+        return bits;
+    }
+};
+
+template <typename First, typename Second>
+struct Radix_Key_Traits<std::pair<First, Second>> : Radix_Tuple_Key_Traits<std::pair<First, Second>> {};
+
+template <typename... Elements>
+struct Radix_Key_Traits<std::tuple<Elements...>> : Radix_Tuple_Key_Traits<std::tuple<Elements...>> {};
+
+template <typename Key>
+typename Radix_Key_Traits<Key>::Bits radix_key_bits(const Key& key) {
+    return Radix_Key_Traits<Key>::to_bits(key);
+}
 
 // Getter can be a lambda, functor, or any object with overloaded operator()
-template <typename RandomAccessIt, typename Getter>
+template <size_t DIGIT_BITS = 8, typename RandomAccessIt, typename Getter>
 void radix_sort(RandomAccessIt begin, RandomAccessIt end, Getter get_value) {
     // Compile-time check: Requires Random Access for square bracket overload indexing and O(1) distance.
     static_assert(
@@ -22,59 +250,326 @@ void radix_sort(RandomAccessIt begin, RandomAccessIt end, Getter get_value) {
 
     using Key = std::decay_t<decltype(get_value(*begin))>;
     using Value = typename std::iterator_traits<RandomAccessIt>::value_type;
+    using Key_Bits = typename Radix_Key_Traits<Key>::Bits;
 
-    using AnySignedInt = decltype(get_value(*begin));
-    using AnyUnsignedInt = std::make_unsigned_t<Key>;
+    constexpr size_t bucket_count = Radix_Digit_Check<DIGIT_BITS>::bucket_count;
+    constexpr size_t num_passes = (Radix_Key_Traits<Key>::bit_count + DIGIT_BITS - 1) / DIGIT_BITS;
+    constexpr size_t DIGIT_MASK = bucket_count - 1;
 
-    constexpr AnyUnsignedInt SIGN_BIT_MASK = std::is_signed<Key>::value
-        ? (AnyUnsignedInt(1) << (sizeof(Key) * 8 - 1))
-        : 0;
+    auto* src = &(*begin);
 
-    // Convert signed int to unsigned int for correct sorting
-    auto get_converted_value = [&](const Value& item) {
-        AnySignedInt signed_val = get_value(item);
-        return static_cast<AnyUnsignedInt>(signed_val) ^ SIGN_BIT_MASK;
-    };
+    // Build the histogram of every pass with a single read of the input
+    std::vector<size_t> counts(num_passes * bucket_count, 0);
+    for (size_t i = 0; i < range_size; ++i) {
+        Key_Bits val = radix_key_bits<Key>(get_value(src[i]));
+        for (size_t pass = 0; pass < num_passes; ++pass) {
+            ++counts[pass * bucket_count + (radix_digit(val, pass * DIGIT_BITS, DIGIT_MASK))];
+        }
+    }
 
-    std::vector<Value> buffer(range_size);
+    // A pass is skipped when one bucket holds every element (e.g. identical high bytes)
+    Key_Bits first_val = radix_key_bits<Key>(get_value(src[0]));
+    bool pass_needed[num_passes];
+    size_t passes_needed = 0;
+    for (size_t pass = 0; pass < num_passes; ++pass) {
+        size_t first_digit = radix_digit(first_val, pass * DIGIT_BITS, DIGIT_MASK);
+        pass_needed[pass] = counts[pass * bucket_count + first_digit] != range_size;
+        if (pass_needed[pass]) ++passes_needed;
+    }
+    if (passes_needed == 0) return;
 
-    auto* src = &(*begin);
+    std::vector<Value> buffer(range_size);
     auto* dest = buffer.data();
 
-    constexpr int num_passes = sizeof(AnySignedInt);
+    for (size_t pass = 0; pass < num_passes; ++pass) {
+        if (!pass_needed[pass]) continue;
 
-    for (int pass = 0; pass < num_passes; ++pass) {
-        size_t count[256] = {0};
-        int shift = pass * 8;
+        size_t* count = &counts[pass * bucket_count];
+        size_t shift = pass * DIGIT_BITS;
+
+        // Exclusive prefix sum turns the counts into bucket start offsets
+        size_t offset = 0;
+        for (size_t i = 0; i < bucket_count; ++i) {
+            size_t bucket_size = count[i];
+            count[i] = offset;
+            offset += bucket_size;
+        }
 
         for (size_t i = 0; i < range_size; ++i) {
-            AnyUnsignedInt val = get_converted_value(src[i]);
-            int digit = (val >> shift) & 0xFF;
-            ++count[digit];
+            Key_Bits val = radix_key_bits<Key>(get_value(src[i]));
+            size_t digit = radix_digit(val, shift, DIGIT_MASK);
+            dest[count[digit]++] = std::move(src[i]);
         }
 
-        for (int i = 1; i < 256; i++) {
-            count[i] += count[i - 1];
+        std::swap(src, dest);
+    }
+
+    if (passes_needed % 2 != 0) {
+        std::move(src, src + range_size, dest);
+    }
+}
+
+template <size_t DIGIT_BITS = 8, typename RandomAccessIt>
+void radix_sort(RandomAccessIt begin, RandomAccessIt end) {
+    static_assert(
+        std::is_base_of<
+            std::random_access_iterator_tag,
+            typename std::iterator_traits<RandomAccessIt>::iterator_category
+        >::value,
+        "Radix sort optimization requires at least a random access iterator."
+    );
+
+    // The elements are their own keys, so they need a Radix_Key_Traits (pairs and tuples sort lexicographically)
+    using Value = typename std::iterator_traits<RandomAccessIt>::value_type;
+
+    radix_sort<DIGIT_BITS>(begin, end, [](const Value& value) { return value; });
+}
+
+// Below this many elements the thread start-up costs more than the parallel passes save
+constexpr size_t PARALLEL_RADIX_SORT_MIN_SIZE = size_t(1) << 16;
+
+// Runs task(thread_index) on thread_count threads, the calling thread included, and waits for all of them
+template <typename Task>
+void run_on_threads(size_t thread_count, Task task) {
+    std::vector<std::thread> workers;
+    workers.reserve(thread_count - 1);
+    for (size_t t = 1; t < thread_count; ++t) {
+        workers.emplace_back(task, t);
+    }
+    task(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+/*
+    Multi-threaded LSD radix sort. The range is split into one contiguous chunk per thread:
+        1. every thread histograms its own chunk (all passes at once, used to skip constant digits)
+        2. per pass, the per-thread histograms are merged with a prefix sum into per-thread bucket offsets
+        3. every thread scatters its own chunk into its reserved slots, which keeps the sort stable
+    Falls back to radix_sort for small ranges or thread_count <= 1.
+    8 or 11 bit digits are recommended here since every thread keeps its own histograms.
+*/
+template <size_t DIGIT_BITS = 8, typename RandomAccessIt, typename Getter>
+void parallel_radix_sort(RandomAccessIt begin, RandomAccessIt end, Getter get_value,
+                         size_t thread_count = std::thread::hardware_concurrency()) {
+    static_assert(
+        std::is_base_of<
+            std::random_access_iterator_tag,
+            typename std::iterator_traits<RandomAccessIt>::iterator_category
+        >::value,
+        "Radix sort optimization requires at least a random access iterator."
+    );
+
+    size_t range_size = std::distance(begin, end);
+    thread_count = std::min(thread_count, range_size / (PARALLEL_RADIX_SORT_MIN_SIZE / 4) + 1);
+    if (thread_count <= 1 or range_size < PARALLEL_RADIX_SORT_MIN_SIZE) {
+        radix_sort<DIGIT_BITS>(begin, end, get_value);
+        return;
+    }
+
+    using Key = std::decay_t<decltype(get_value(*begin))>;
+    using Value = typename std::iterator_traits<RandomAccessIt>::value_type;
+    using Key_Bits = typename Radix_Key_Traits<Key>::Bits;
+
+    constexpr size_t bucket_count = Radix_Digit_Check<DIGIT_BITS>::bucket_count;
+    constexpr size_t num_passes = (Radix_Key_Traits<Key>::bit_count + DIGIT_BITS - 1) / DIGIT_BITS;
+    constexpr size_t DIGIT_MASK = bucket_count - 1;
+
+    std::vector<size_t> chunk_starts(thread_count + 1);
+    for (size_t t = 0; t <= thread_count; ++t) {
+        chunk_starts[t] = range_size * t / thread_count;
+    }
+
+    auto* src = &(*begin);
+
+    // 1. Per-thread histograms of every pass
+    std::vector<std::vector<size_t>> local_counts(thread_count);
+    run_on_threads(thread_count, [&](size_t t) {
+        std::vector<size_t>& counts = local_counts[t];
+        counts.assign(num_passes * bucket_count, 0);
+        for (size_t i = chunk_starts[t]; i < chunk_starts[t + 1]; ++i) {
+            Key_Bits val = radix_key_bits<Key>(get_value(src[i]));
+            for (size_t pass = 0; pass < num_passes; ++pass) {
+                ++counts[pass * bucket_count + (radix_digit(val, pass * DIGIT_BITS, DIGIT_MASK))];
+            }
         }
+    });
+
+    Key_Bits first_val = radix_key_bits<Key>(get_value(src[0]));
+    bool pass_needed[num_passes];
+    size_t passes_needed = 0;
+    for (size_t pass = 0; pass < num_passes; ++pass) {
+        size_t first_bucket = pass * bucket_count + (radix_digit(first_val, pass * DIGIT_BITS, DIGIT_MASK));
+        size_t total = 0;
+        for (size_t t = 0; t < thread_count; ++t) {
+            total += local_counts[t][first_bucket];
+        }
+        pass_needed[pass] = total != range_size;
+        if (pass_needed[pass]) ++passes_needed;
+    }
+    if (passes_needed == 0) return;
 
-        for (size_t i = range_size; i > 0; --i) {
-            AnyUnsignedInt val = get_converted_value(src[i - 1]);
-            int digit = (val >> shift) & 0xFF;
+    std::vector<Value> buffer(range_size);
+    auto* dest = buffer.data();
 
-            dest[count[digit] - 1] = std::move(src[i - 1]);
-            --count[digit];
+    // The first histograms describe the original layout, later passes must recount their chunk
+    bool counts_current = true;
+    std::vector<size_t> offsets(thread_count * bucket_count);
+
+    for (size_t pass = 0; pass < num_passes; ++pass) {
+        if (!pass_needed[pass]) continue;
+        size_t shift = pass * DIGIT_BITS;
+
+        if (!counts_current) {
+            run_on_threads(thread_count, [&](size_t t) {
+                size_t* count = &local_counts[t][pass * bucket_count];
+                std::fill(count, count + bucket_count, 0);
+                for (size_t i = chunk_starts[t]; i < chunk_starts[t + 1]; ++i) {
+                    Key_Bits val = radix_key_bits<Key>(get_value(src[i]));
+                    ++count[radix_digit(val, shift, DIGIT_MASK)];
+                }
+            });
+        }
+        counts_current = false;
+
+        // 2. Prefix sum over (bucket, thread) so each thread owns a slice of every bucket
+        size_t offset = 0;
+        for (size_t digit = 0; digit < bucket_count; ++digit) {
+            for (size_t t = 0; t < thread_count; ++t) {
+                offsets[t * bucket_count + digit] = offset;
+                offset += local_counts[t][pass * bucket_count + digit];
+            }
         }
 
+        // 3. Partitioned scatter
+        run_on_threads(thread_count, [&](size_t t) {
+            size_t* offset_of = &offsets[t * bucket_count];
+            for (size_t i = chunk_starts[t]; i < chunk_starts[t + 1]; ++i) {
+                Key_Bits val = radix_key_bits<Key>(get_value(src[i]));
+                dest[offset_of[radix_digit(val, shift, DIGIT_MASK)]++] = std::move(src[i]);
+            }
+        });
+
         std::swap(src, dest);
     }
 
-    if (num_passes % 2 != 0) {
-        std::copy(src, src + range_size, dest);
+    if (passes_needed % 2 != 0) {
+        run_on_threads(thread_count, [&](size_t t) {
+            std::move(src + chunk_starts[t], src + chunk_starts[t + 1], dest + chunk_starts[t]);
+        });
     }
 }
 
-template <typename RandomAccessIt>
-void radix_sort(RandomAccessIt begin, RandomAccessIt end) {
+// Buckets at or below this size are finished with insertion sort by in_place_radix_sort
+constexpr size_t IN_PLACE_RADIX_SORT_INSERTION_CUTOFF = 32;
+
+template <typename Value, typename Getter>
+void radix_insertion_sort(Value* data, size_t size, Getter get_value) {
+    using Key = std::decay_t<decltype(get_value(*data))>;
+    for (size_t i = 1; i < size; ++i) {
+        auto key_bits = radix_key_bits<Key>(get_value(data[i]));
+        if (!(key_bits < radix_key_bits<Key>(get_value(data[i - 1])))) continue;
+
+        Value moving = std::move(data[i]);
+        size_t j = i;
+        while (j > 0 and key_bits < radix_key_bits<Key>(get_value(data[j - 1]))) {
+            data[j] = std::move(data[j - 1]);
+            --j;
+        }
+        data[j] = std::move(moving);
+    }
+}
+
+// One American flag level: permute data in place by the 8-bit digit at shift, then recurse into each bucket
+template <typename Value, typename Getter>
+void american_flag_sort(Value* data, size_t size, int shift, Getter get_value) {
+    using Key = std::decay_t<decltype(get_value(*data))>;
+    using Key_Bits = typename Radix_Key_Traits<Key>::Bits;
+
+    if (size <= IN_PLACE_RADIX_SORT_INSERTION_CUTOFF) {
+        radix_insertion_sort(data, size, get_value);
+        return;
+    }
+
+    size_t bucket_next[256];
+    size_t bucket_end[256];
+    while (true) {
+        std::fill(bucket_end, bucket_end + 256, 0);
+        for (size_t i = 0; i < size; ++i) {
+            Key_Bits val = radix_key_bits<Key>(get_value(data[i]));
+            ++bucket_end[radix_digit(val, shift, 0xFF)];
+        }
+
+        // Constant digit: nothing to permute, go straight to the next digit
+        size_t first_digit = radix_digit(radix_key_bits<Key>(get_value(data[0])), shift, 0xFF);
+        if (bucket_end[first_digit] != size) break;
+        if (shift == 0) return;
+        shift -= 8;
+    }
+
+    size_t offset = 0;
+    for (size_t digit = 0; digit < 256; ++digit) {
+        bucket_next[digit] = offset;
+        offset += bucket_end[digit];
+        bucket_end[digit] = offset;
+    }
+
+    // Cycle leader permutation: every swap drops one element into its final bucket
+    for (size_t digit = 0; digit < 256; ++digit) {
+        while (bucket_next[digit] < bucket_end[digit]) {
+            Value moving = std::move(data[bucket_next[digit]]);
+            size_t moving_digit = radix_digit(radix_key_bits<Key>(get_value(moving)), shift, 0xFF);
+            while (moving_digit != digit) {
+                std::swap(moving, data[bucket_next[moving_digit]++]);
+                moving_digit = radix_digit(radix_key_bits<Key>(get_value(moving)), shift, 0xFF);
+            }
+            data[bucket_next[digit]++] = std::move(moving);
+        }
+    }
+
+    if (shift == 0) return;
+
+    size_t bucket_start = 0;
+    for (size_t digit = 0; digit < 256; ++digit) {
+        size_t bucket_size = bucket_end[digit] - bucket_start;
+        if (bucket_size > 1) {
+            american_flag_sort(data + bucket_start, bucket_size, shift - 8, get_value);
+        }
+        bucket_start = bucket_end[digit];
+    }
+}
+
+/*
+    In-place MSD (American flag) radix sort with 8-bit digits.
+    Needs no scratch buffer, only two 256-entry tables per recursion level (at most one per key byte),
+    so peak memory stays at the size of the range. Unlike the LSD sorts it is NOT stable.
+*/
+template <typename RandomAccessIt, typename Getter>
+void in_place_radix_sort(RandomAccessIt begin, RandomAccessIt end, Getter get_value) {
+    static_assert(
+        std::is_base_of<
+            std::random_access_iterator_tag,
+            typename std::iterator_traits<RandomAccessIt>::iterator_category
+        >::value,
+        "Radix sort optimization requires at least a random access iterator."
+    );
+
+    size_t range_size = std::distance(begin, end);
+    if (range_size <= 1) return;
+
+    using Key = std::decay_t<decltype(get_value(*begin))>;
+    constexpr size_t top_shift = (Radix_Key_Traits<Key>::bit_count + 7) / 8 * 8 - 8;
+    american_flag_sort(&(*begin), range_size, static_cast<int>(top_shift), get_value);
+}
+
+/*
+    Indirect LSD radix sort for elements that are expensive to move (e.g. pairs with large values).
+    Only compact (key bits, uint32 index) tuples go through the radix passes, then a single
+    cycle-following permutation pass moves every element once into its final slot. Stable.
+*/
+template <size_t DIGIT_BITS = 8, typename RandomAccessIt, typename Getter>
+void indirect_radix_sort(RandomAccessIt begin, RandomAccessIt end, Getter get_value, size_t thread_count = 1) {
     static_assert(
         std::is_base_of<
             std::random_access_iterator_tag,
@@ -83,20 +578,321 @@ void radix_sort(RandomAccessIt begin, RandomAccessIt end) {
         "Radix sort optimization requires at least a random access iterator."
     );
 
+    size_t range_size = std::distance(begin, end);
+    if (range_size <= 1) return;
+
+    // uint32 indices cannot address larger ranges
+    if (range_size > std::numeric_limits<uint32_t>::max()) {
+        parallel_radix_sort<DIGIT_BITS>(begin, end, get_value, thread_count);
+        return;
+    }
+
+    using Key = std::decay_t<decltype(get_value(*begin))>;
     using Value = typename std::iterator_traits<RandomAccessIt>::value_type;
+    using Key_Bits = typename Radix_Key_Traits<Key>::Bits;
+
+    struct Key_Index {
+        Key_Bits key_bits;
+        uint32_t index;
+    };
 
+    auto* data = &(*begin);
+    std::vector<Key_Index> key_indices(range_size);
+    for (size_t i = 0; i < range_size; ++i) {
+        key_indices[i].key_bits = radix_key_bits<Key>(get_value(data[i]));
+        key_indices[i].index = static_cast<uint32_t>(i);
+    }
+
+    parallel_radix_sort<DIGIT_BITS>(key_indices.begin(), key_indices.end(),
+        [](const Key_Index& key_index) { return key_index.key_bits; }, thread_count);
+
+    // key_indices[i].index is where the element that belongs at i currently lives.
+    // Follow each cycle once, marking finished slots by pointing them at themselves.
+    for (size_t i = 0; i < range_size; ++i) {
+        if (key_indices[i].index == i) continue;
+
+        Value moving = std::move(data[i]);
+        size_t slot = i;
+        while (true) {
+            size_t from = key_indices[slot].index;
+            key_indices[slot].index = static_cast<uint32_t>(slot);
+            if (from == i) {
+                data[slot] = std::move(moving);
+                break;
+            }
+            data[slot] = std::move(data[from]);
+            slot = from;
+        }
+    }
+}
+
+enum class Radix_Sort_Mode {
+    LSD_BUFFERED,   // stable, allocates a scratch buffer as large as the range (parallel when thread_count > 1)
+    MSD_IN_PLACE,   // American flag sort, no scratch buffer, not stable, always 8-bit digits
+    LSD_INDIRECT    // sorts (key, index) tuples then permutes the elements once, for large elements
+};
+
+// Picks the sort per call, e.g. radix_sort(vec.begin(), vec.end(), getter, Radix_Sort_Mode::MSD_IN_PLACE)
+template <size_t DIGIT_BITS = 8, typename RandomAccessIt, typename Getter>
+void radix_sort(RandomAccessIt begin, RandomAccessIt end, Getter get_value,
+                Radix_Sort_Mode mode, size_t thread_count = 1) {
+    switch (mode) {
+        case Radix_Sort_Mode::MSD_IN_PLACE:
+            in_place_radix_sort(begin, end, get_value);
+            break;
+        case Radix_Sort_Mode::LSD_INDIRECT:
+            indirect_radix_sort<DIGIT_BITS>(begin, end, get_value, thread_count);
+            break;
+        case Radix_Sort_Mode::LSD_BUFFERED:
+        default:
+            parallel_radix_sort<DIGIT_BITS>(begin, end, get_value, thread_count);
+            break;
+    }
+}
+
+// ---Parallel key and value arrays---
+
+// One American flag level over two arrays: every swap moves a key and its value together, no scratch buffer
+template <typename Key, typename Value>
+void american_flag_sort_by_key(Key* keys, Value* values, size_t size, int shift) {
+    using Key_Bits = typename Radix_Key_Traits<Key>::Bits;
+
+    if (size <= IN_PLACE_RADIX_SORT_INSERTION_CUTOFF) {
+        for (size_t i = 1; i < size; ++i) {
+            for (size_t j = i; j > 0 and radix_key_bits<Key>(keys[j]) < radix_key_bits<Key>(keys[j - 1]); --j) {
+                std::swap(keys[j], keys[j - 1]);
+                std::swap(values[j], values[j - 1]);
+            }
+        }
+        return;
+    }
+
+    size_t bucket_next[256];
+    size_t bucket_end[256];
+    while (true) {
+        std::fill(bucket_end, bucket_end + 256, 0);
+        for (size_t i = 0; i < size; ++i) {
+            Key_Bits val = radix_key_bits<Key>(keys[i]);
+            ++bucket_end[radix_digit(val, shift, 0xFF)];
+        }
+
+        // Constant digit: nothing to permute, go straight to the next digit
+        size_t first_digit = radix_digit(radix_key_bits<Key>(keys[0]), shift, 0xFF);
+        if (bucket_end[first_digit] != size) break;
+        if (shift == 0) return;
+        shift -= 8;
+    }
+
+    size_t offset = 0;
+    for (size_t digit = 0; digit < 256; ++digit) {
+        bucket_next[digit] = offset;
+        offset += bucket_end[digit];
+        bucket_end[digit] = offset;
+    }
+
+    // Swap the pair at the front of each bucket into the bucket of its digit until it belongs where it is
+    for (size_t digit = 0; digit < 256; ++digit) {
+        while (bucket_next[digit] < bucket_end[digit]) {
+            size_t pos = bucket_next[digit];
+            size_t pos_digit = radix_digit(radix_key_bits<Key>(keys[pos]), shift, 0xFF);
+            if (pos_digit == digit) {
+                ++bucket_next[digit];
+                continue;
+            }
+            size_t target = bucket_next[pos_digit]++;
+            std::swap(keys[pos], keys[target]);
+            std::swap(values[pos], values[target]);
+        }
+    }
+
+    if (shift == 0) return;
+
+    size_t bucket_start = 0;
+    for (size_t digit = 0; digit < 256; ++digit) {
+        size_t bucket_size = bucket_end[digit] - bucket_start;
+        if (bucket_size > 1) {
+            american_flag_sort_by_key(keys + bucket_start, values + bucket_start, bucket_size, shift - 8);
+        }
+        bucket_start = bucket_end[digit];
+    }
+}
+
+/*
+    Applies a sorted order to two arrays: index_of(order[i]) is where the pair that belongs at i lives.
+    Follows each cycle once, moving every key and value a single time; index_of(order[i]) ends up as i.
+*/
+template <typename Key, typename Value, typename Order, typename Index_Of>
+void radix_permute_by_order(Key* keys, Value* values, Order* order, size_t size, Index_Of index_of) {
+    for (size_t i = 0; i < size; ++i) {
+        if (index_of(order[i]) == i) continue;
+
+        Key moving_key = std::move(keys[i]);
+        Value moving_value = std::move(values[i]);
+        size_t slot = i;
+        while (true) {
+            size_t from = index_of(order[slot]);
+            index_of(order[slot]) = slot;
+            if (from == i) {
+                keys[slot] = std::move(moving_key);
+                values[slot] = std::move(moving_value);
+                break;
+            }
+            keys[slot] = std::move(keys[from]);
+            values[slot] = std::move(values[from]);
+            slot = from;
+        }
+    }
+}
+
+/*
+    Sorts values_begin[i] along with keys_begin[i] by key, for key and value arrays kept side by side.
+    MSD_IN_PLACE swaps both arrays in place with no scratch buffer (not stable). The LSD modes are stable:
+    compact (key bits, index) tuples go through the radix passes, then every pair is moved once.
+*/
+template <size_t DIGIT_BITS = 8, typename KeyIt, typename ValueIt>
+void radix_sort_by_key(KeyIt keys_begin, KeyIt keys_end, ValueIt values_begin,
+                       Radix_Sort_Mode mode = Radix_Sort_Mode::LSD_BUFFERED, size_t thread_count = 1) {
     static_assert(
-        std::is_integral<Value>::value,
-        "Radix sort without getter requires Value to be an integral type. "
-        "For pairs or custom types, provide a getter function."
+        std::is_base_of<
+            std::random_access_iterator_tag,
+            typename std::iterator_traits<KeyIt>::iterator_category
+        >::value,
+        "Radix sort optimization requires at least a random access iterator."
+    );
+
+    size_t range_size = std::distance(keys_begin, keys_end);
+    if (range_size <= 1) return;
+
+    using Key = typename std::iterator_traits<KeyIt>::value_type;
+    using Key_Bits = typename Radix_Key_Traits<Key>::Bits;
+
+    auto* keys = &(*keys_begin);
+    auto* values = &(*values_begin);
+    if (mode == Radix_Sort_Mode::MSD_IN_PLACE) {
+        constexpr size_t top_shift = (Radix_Key_Traits<Key>::bit_count + 7) / 8 * 8 - 8;
+        american_flag_sort_by_key(keys, values, range_size, static_cast<int>(top_shift));
+        return;
+    }
+
+    struct Key_Index {
+        Key_Bits key_bits;
+        size_t index;
+    };
+
+    std::vector<Key_Index> key_indices(range_size);
+    for (size_t i = 0; i < range_size; ++i) {
+        key_indices[i].key_bits = radix_key_bits<Key>(keys[i]);
+        key_indices[i].index = i;
+    }
+    parallel_radix_sort<DIGIT_BITS>(key_indices.begin(), key_indices.end(),
+        [](const Key_Index& key_index) { return key_index.key_bits; }, thread_count);
+    radix_permute_by_order(keys, values, key_indices.data(), range_size,
+        [](Key_Index& key_index) -> size_t& { return key_index.index; });
+}
+
+// ---Byte string keys---
+
+// Byte at depth, shifted up by one so a string that already ended (bucket 0) sorts before any real byte
+inline size_t string_radix_digit(const std::string& key, size_t depth) {
+    return depth < key.size() ? static_cast<size_t>(static_cast<unsigned char>(key[depth])) + 1 : 0;
+}
+
+/*
+    In-place MSD (American flag) radix sort for std::string keys, one byte per level.
+    get_value should return the key by const reference. Work is kept on an explicit stack instead of
+    recursion, so long shared prefixes cannot overflow the call stack. Not stable.
+*/
+template <typename RandomAccessIt, typename Getter>
+void string_radix_sort(RandomAccessIt begin, RandomAccessIt end, Getter get_value) {
+    static_assert(
+        std::is_base_of<
+            std::random_access_iterator_tag,
+            typename std::iterator_traits<RandomAccessIt>::iterator_category
+        >::value,
+        "Radix sort optimization requires at least a random access iterator."
     );
 
-    radix_sort(begin, end, [](const Value& value) { return value; });
+    using Value = typename std::iterator_traits<RandomAccessIt>::value_type;
+
+    size_t range_size = std::distance(begin, end);
+    if (range_size <= 1) return;
+
+    struct Bucket_Task {
+        size_t start;
+        size_t size;
+        size_t depth;
+    };
+
+    auto* data = &(*begin);
+    std::vector<Bucket_Task> tasks;
+    tasks.push_back({0, range_size, 0});
+
+    size_t bucket_next[257];
+    size_t bucket_end[257];
+
+    while (!tasks.empty()) {
+        Bucket_Task task = tasks.back();
+        tasks.pop_back();
+        Value* bucket = data + task.start;
+
+        // Small buckets: insertion sort, comparing only the bytes past the shared prefix
+        if (task.size <= IN_PLACE_RADIX_SORT_INSERTION_CUTOFF) {
+            for (size_t i = 1; i < task.size; ++i) {
+                size_t j = i;
+                while (j > 0 and get_value(bucket[j]).compare(task.depth, std::string::npos,
+                           get_value(bucket[j - 1]), task.depth, std::string::npos) < 0) {
+                    std::swap(bucket[j], bucket[j - 1]);
+                    --j;
+                }
+            }
+            continue;
+        }
+
+        std::fill(bucket_end, bucket_end + 257, 0);
+        for (size_t i = 0; i < task.size; ++i) {
+            ++bucket_end[string_radix_digit(get_value(bucket[i]), task.depth)];
+        }
+
+        // Every string shares this byte: move on to the next one (unless they all ended)
+        size_t first_digit = string_radix_digit(get_value(bucket[0]), task.depth);
+        if (bucket_end[first_digit] == task.size) {
+            if (first_digit != 0) tasks.push_back({task.start, task.size, task.depth + 1});
+            continue;
+        }
+
+        size_t offset = 0;
+        for (size_t digit = 0; digit < 257; ++digit) {
+            bucket_next[digit] = offset;
+            offset += bucket_end[digit];
+            bucket_end[digit] = offset;
+        }
+
+        for (size_t digit = 0; digit < 257; ++digit) {
+            while (bucket_next[digit] < bucket_end[digit]) {
+                Value moving = std::move(bucket[bucket_next[digit]]);
+                size_t moving_digit = string_radix_digit(get_value(moving), task.depth);
+                while (moving_digit != digit) {
+                    std::swap(moving, bucket[bucket_next[moving_digit]++]);
+                    moving_digit = string_radix_digit(get_value(moving), task.depth);
+                }
+                bucket[bucket_next[digit]++] = std::move(moving);
+            }
+        }
+
+        // Bucket 0 holds strings that ended here, they are all equal
+        for (size_t digit = 1; digit < 257; ++digit) {
+            size_t bucket_start = bucket_end[digit - 1];
+            size_t bucket_size = bucket_end[digit] - bucket_start;
+            if (bucket_size > 1) {
+                tasks.push_back({task.start + bucket_start, bucket_size, task.depth + 1});
+            }
+        }
+    }
 }
 
 // ---Doubly linked list overloads---
 
-template <typename List, typename Getter>
+template <size_t DIGIT_BITS = 8, typename List, typename Getter>
 void radix_sort(List& list, Getter get_value) {
     // Accessing internal types from the list
     using Node = typename List::Node;
@@ -106,31 +902,35 @@ void radix_sort(List& list, Getter get_value) {
     // Don't sort if empty or single element
     if (list.head == nullptr or list.head == list.tail) return;
 
-    using AnyUnsignedInt = std::make_unsigned_t<Key>;
+    using Key_Bits = typename Radix_Key_Traits<Key>::Bits;
 
-    constexpr AnyUnsignedInt SIGN_BIT_MASK = std::is_signed<Key>::value
-        ? (AnyUnsignedInt(1) << (sizeof(Key) * 8 - 1))
-        : 0;
+    constexpr size_t bucket_count = Radix_Digit_Check<DIGIT_BITS>::bucket_count;
+    constexpr size_t num_passes = (Radix_Key_Traits<Key>::bit_count + DIGIT_BITS - 1) / DIGIT_BITS;
+    constexpr size_t DIGIT_MASK = bucket_count - 1;
 
-    auto get_converted_value = [&](const Value& item) {
-        Key signed_val = get_value(item);
-        return static_cast<AnyUnsignedInt>(signed_val) ^ SIGN_BIT_MASK;
-    };
+    // Histogram every pass in one walk so constant digits can be skipped
+    std::vector<size_t> counts(num_passes * bucket_count, 0);
+    size_t list_size = 0;
+    for (Node* curr_node = list.head; curr_node != nullptr; curr_node = curr_node->next) {
+        Key_Bits val = radix_key_bits<Key>(get_value(curr_node->value));
+        for (size_t pass = 0; pass < num_passes; ++pass) {
+            ++counts[pass * bucket_count + (radix_digit(val, pass * DIGIT_BITS, DIGIT_MASK))];
+        }
+        ++list_size;
+    }
+    Key_Bits first_val = radix_key_bits<Key>(get_value(list.head->value));
 
-    constexpr int num_passes = sizeof(Key);
+    // Buckets for every radix (Head and Tail for O(1) append)
+    std::vector<Node*> bucket_heads(bucket_count);
+    std::vector<Node*> bucket_tails(bucket_count);
 
-    // Buckets for 256 radices (Head and Tail for O(1) append)
-    Node* bucket_heads[256];
-    Node* bucket_tails[256];
+    for (size_t pass = 0; pass < num_passes; ++pass) {
+        size_t shift = pass * DIGIT_BITS;
+        if (counts[pass * bucket_count + (radix_digit(first_val, shift, DIGIT_MASK))] == list_size) continue;
 
-    for (int pass = 0; pass < num_passes; ++pass) {
         // Reset buckets
-        for(int i = 0; i < 256; ++i) {
-            bucket_heads[i] = nullptr;
-            bucket_tails[i] = nullptr;
-        }
-
-        int shift = pass * 8;
+        std::fill(bucket_heads.begin(), bucket_heads.end(), nullptr);
+        std::fill(bucket_tails.begin(), bucket_tails.end(), nullptr);
 
         // 1. Distribute nodes into buckets
         Node* curr_node = list.head;
@@ -138,8 +938,8 @@ void radix_sort(List& list, Getter get_value) {
             Node* next_node = curr_node->next;
 
             // Calculate bucket index
-            AnyUnsignedInt val = get_converted_value(curr_node->value);
-            int digit = (val >> shift) & 0xFF;
+            Key_Bits val = radix_key_bits<Key>(get_value(curr_node->value));
+            size_t digit = radix_digit(val, shift, DIGIT_MASK);
 
             // Isolate current node
             curr_node->next = nullptr;
@@ -163,7 +963,7 @@ void radix_sort(List& list, Getter get_value) {
         list.head = nullptr;
         list.tail = nullptr;
 
-        for (int i = 0; i < 256; ++i) {
+        for (size_t i = 0; i < bucket_count; ++i) {
             if (bucket_heads[i] != nullptr) {
                 if (list.head == nullptr) {
                     list.head = bucket_heads[i];
@@ -184,10 +984,10 @@ void radix_sort(List& list, Getter get_value) {
     }
 }
 
-template <typename List>
+template <size_t DIGIT_BITS = 8, typename List>
 void radix_sort(List& list) {
     using Value = typename std::iterator_traits<typename List::iterator>::value_type;
-    radix_sort(list, [](const Value& val) { return val; });
+    radix_sort<DIGIT_BITS>(list, [](const Value& val) { return val; });
 }
 
-#endif //RADIX_SORT_H
\ No newline at end of file
+#endif //RADIX_SORT_H
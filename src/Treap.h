@@ -8,26 +8,39 @@
 #include <queue>
 #include <random>
 #include <vector>
-template<typename Key, typename Value>
+#include "Node_Pool.h"
+#include "Order_Statistics.h"
+#include "Path_Buffer.h"
+
+// ORDER_STATISTICS keeps subtree sizes in every node for O(log N) rank, select and range_count,
+// Node_Allocator builds and frees the nodes (see Node_Pool.h)
+template<typename Key, typename Value, bool ORDER_STATISTICS = false, template<typename> class Node_Allocator = Node_Pool>
 class Treap{
     public:
-        struct Node{
+        struct Node : Subtree_Size<ORDER_STATISTICS> {
             std::pair<Key,Value> data;
             Node* left;
             Node* right;
+            Node* parent;
             size_t priority;
-            Node() : left(nullptr), right(nullptr), priority(0){}
+            Node() : left(nullptr), right(nullptr), parent(nullptr), priority(0){}
         };
     private:
         Node* root;
+        // Cached smallest and largest nodes, so begin() and --end() need no descent
+        Node* leftmost;
+        Node* rightmost;
         size_t node_count;
+        Node_Allocator<Node> node_allocator;
         std::mt19937_64 engine;
         std::uniform_int_distribution<std::size_t> dist_size_t;
+        using Order_Statistics_Tag = std::integral_constant<bool, ORDER_STATISTICS>;
 
-        Node* successor(Node* nav_node){
+        // Parent links make a full scan O(N): every edge is climbed or descended at most twice
+        static Node* successor(Node* nav_node){
             // Case 1: If node has a right subtree,
             // the successor is the leftmost node in the right subtree.
-            if(nav_node != nullptr && nav_node->right != nullptr){
+            if(nav_node->right != nullptr){
                 Node* succ = nav_node->right;
                 while(succ->left != nullptr){
                     succ = succ->left;
@@ -38,30 +51,16 @@ class Treap{
             // Case 2: If node has no right subtree,
             // the successor is the lowest ancestor for which
             // the navigation node is in its left subtree.
-            // We go back to the root instead of continuing
-            // at the navigation node.
-            Node* succ = nullptr;
-            Node* nav_node2 = this->root;
-            while (nav_node2 != nullptr) {
-                if (nav_node->data.first < nav_node2->data.first) {
-                    succ = nav_node2;
-                    nav_node2 = nav_node2->left;
-                }
-                else if (nav_node->data.first > nav_node2->data.first) {
-                    nav_node2 = nav_node2->right;
-                }
-                else {
-                    // Arrived at the original node
-                    break;
-                }
+            while (nav_node->parent != nullptr and nav_node->parent->right == nav_node) {
+                nav_node = nav_node->parent;
             }
-            return succ;
+            return nav_node->parent;
         }
 
-        Node* predecessor(Node* nav_node){
+        static Node* predecessor(Node* nav_node){
             // Case 1: If node has a left subtree,
-            // the successor is the rightmost node in the left subtree.
-            if(nav_node != nullptr && nav_node->left != nullptr){
+            // the predecessor is the rightmost node in the left subtree.
+            if(nav_node->left != nullptr){
                 Node* pred = nav_node->left;
                 while(pred->right != nullptr){
                     pred = pred->right;
@@ -72,27 +71,13 @@ class Treap{
             // Case 2: If node has no left subtree,
             // the predecessor is the lowest ancestor for which
             // the navigation node is in its right subtree.
-            // We go back to the root instead of continuing
-            // at the navigation node.
-            Node* pred = nullptr;
-            Node* nav_node2 = this->root;
-            while (nav_node2 != nullptr) {
-                if (nav_node->data.first > nav_node2->data.first) {
-                    pred = nav_node2;
-                    nav_node2 = nav_node2->right;
-                }
-                else if (nav_node->data.first < nav_node2->data.first) {
-                    nav_node2 = nav_node2->left;
-                }
-                else {
-                    // Arrived at the original node
-                    break;
-                }
+            while (nav_node->parent != nullptr and nav_node->parent->left == nav_node) {
+                nav_node = nav_node->parent;
             }
-            return pred;
+            return nav_node->parent;
         }
 
-        void bubble_up(std::vector<Node*>& path2parent, Node* inserted_node) {
+        void bubble_up(Path_Buffer<Node*>& path2parent, Node* inserted_node) {
 
             Node* child = inserted_node;
 
@@ -130,6 +115,55 @@ class Treap{
                 }
             }
         }
+
+        // In-order walk of [lo, hi]: subtrees wholly below lo are never entered and the walk stops
+        // at the first key past hi, so it costs O(log N + K) without the per-step root descents of ++
+        template<typename Visit>
+        void range_walk(const Key& lo, const Key& hi, Visit visit) const {
+            Path_Buffer<Node*> node_storage;
+            Node* nav_node = this->root;
+            while (nav_node != nullptr or !node_storage.empty()) {
+                while (nav_node != nullptr) {
+                    if (nav_node->data.first < lo) {
+                        nav_node = nav_node->right;
+                    }
+                    else {
+                        node_storage.push_back(nav_node);
+                        nav_node = nav_node->left;
+                    }
+                }
+                if (node_storage.empty()) return;
+                nav_node = node_storage.back();
+                node_storage.pop_back();
+                if (hi < nav_node->data.first) return;
+                visit(nav_node);
+                nav_node = nav_node->right;
+            }
+        }
+
+        // Two rank descents with the augmentation, a range walk without it
+        size_t range_count(const Key& lo, const Key& hi, std::true_type) const {
+            if (hi < lo) return 0;
+            return subtree_rank<true>(this->root, hi) - subtree_rank<false>(this->root, lo);
+        }
+
+        size_t range_count(const Key& lo, const Key& hi, std::false_type) const {
+            size_t count = 0;
+            range_walk(lo, hi, [&count](const Node*) { ++count; });
+            return count;
+        }
+
+        // After a leaf is snipped, its ancestors are exactly the search path for its key
+        void shrink_search_path(const Key& key, std::true_type) {
+            Node* nav_node = this->root;
+            while (nav_node != nullptr) {
+                --nav_node->subtree_size;
+                nav_node = key < nav_node->data.first ? nav_node->left : nav_node->right;
+            }
+        }
+
+        void shrink_search_path(const Key&, std::false_type) {}
+
     public:
         class const_iterator;
 
@@ -190,11 +224,7 @@ class Treap{
             // Pre-decrement (--it)
             iterator& operator--() {
                 if (node_ptr == nullptr) {
-                    Node* max_node = treap_ptr->root;
-                    if (max_node != nullptr) {
-                        while (max_node->right != nullptr) max_node = max_node->right;
-                    }
-                    node_ptr = max_node;
+                    node_ptr = treap_ptr->rightmost;
                 } else {
                     node_ptr = treap_ptr->predecessor(node_ptr);
                 }
@@ -285,11 +315,7 @@ class Treap{
             // Pre-decrement (--it)
             const_iterator& operator--() {
                 if (node_ptr == nullptr) {
-                    Node* max_node = treap_ptr->root;
-                    if (max_node != nullptr) {
-                        while (max_node->right != nullptr) max_node = max_node->right;
-                    }
-                    node_ptr = max_node;
+                    node_ptr = treap_ptr->rightmost;
                 } else {
                     node_ptr = treap_ptr->predecessor(node_ptr);
                 }
@@ -324,6 +350,8 @@ class Treap{
 
         //init random ID generator and treap
         Treap() : root(nullptr),
+              leftmost(nullptr),
+              rightmost(nullptr),
               node_count(0),
               engine(std::random_device{}()),
               dist_size_t(0, std::numeric_limits<std::size_t>::max())
@@ -351,14 +379,24 @@ class Treap{
         Node* rotateLeft(Node* node) {
             Node* new_root_of_subtree = node->right;
             node->right = new_root_of_subtree->left;
+            if (node->right != nullptr) node->right->parent = node;
             new_root_of_subtree->left = node;
+            new_root_of_subtree->parent = node->parent;
+            node->parent = new_root_of_subtree;
+            update_subtree_size(node, Order_Statistics_Tag{});
+            update_subtree_size(new_root_of_subtree, Order_Statistics_Tag{});
             return new_root_of_subtree;
         }
 
         Node* rotateRight(Node* node) {
             Node* new_root_of_subtree = node->left;
             node->left = new_root_of_subtree->right;
+            if (node->left != nullptr) node->left->parent = node;
             new_root_of_subtree->right = node;
+            new_root_of_subtree->parent = node->parent;
+            node->parent = new_root_of_subtree;
+            update_subtree_size(node, Order_Statistics_Tag{});
+            update_subtree_size(new_root_of_subtree, Order_Statistics_Tag{});
             return new_root_of_subtree;
         }
 
@@ -367,13 +405,15 @@ class Treap{
         }
 
         bool insert(const Key& key, const Value& value){
-            Node* new_node = new Node();
+            Node* new_node = node_allocator.create();
             new_node->data.first = key;
             new_node->data.second = value;
             new_node->priority = dist_size_t(engine);
-            std::vector<Node*> path2parent;
+            Path_Buffer<Node*> path2parent;
             if(this->root == nullptr){
                 this->root = new_node;
+                this->leftmost = new_node;
+                this->rightmost = new_node;
                 ++this->node_count;
                 return true;
             }
@@ -398,10 +438,16 @@ class Treap{
                     }
                 }
                 else{
-                    delete new_node;
+                    node_allocator.destroy(new_node);
                     return false;
                 }
             }
+            new_node->parent = follower_node;
+            if (follower_node == this->leftmost and follower_node->left == new_node) this->leftmost = new_node;
+            if (follower_node == this->rightmost and follower_node->right == new_node) this->rightmost = new_node;
+            for (size_t i = path2parent.size(); i > 0; --i) {
+                update_subtree_size(path2parent[i - 1], Order_Statistics_Tag{});
+            }
             bubble_up(path2parent, new_node);
             ++this->node_count;
             return true;
@@ -460,6 +506,8 @@ class Treap{
             if (nav_node == nullptr) {
                 return false;
             }
+            if (nav_node == this->leftmost) this->leftmost = successor(nav_node);
+            if (nav_node == this->rightmost) this->rightmost = predecessor(nav_node);
 
             // 2. Bubble down loop
             while (nav_node->left != nullptr or nav_node->right != nullptr) {
@@ -506,7 +554,8 @@ class Treap{
                 follower_node->right = nullptr;
             }
 
-            delete nav_node;
+            node_allocator.destroy(nav_node);
+            shrink_search_path(key, Order_Statistics_Tag{});
             --this->node_count;
             return true;
         }
@@ -515,20 +564,26 @@ class Treap{
             if (this->root == nullptr) {
                 return;
             }
-            std::queue<Node*> q;
-            q.push(this->root);
-            while(!q.empty()){
-                Node* nav_node = q.front();
-                q.pop();
-                if(nav_node->left != nullptr){
-                    q.push(nav_node->left);
-                }
-                if(nav_node->right != nullptr){
-                    q.push(nav_node->right);
+            // Trivially destructible nodes go back with their slabs, no walk needed
+            if (!Node_Allocator<Node>::BULK_RELEASE) {
+                std::queue<Node*> q;
+                q.push(this->root);
+                while(!q.empty()){
+                    Node* nav_node = q.front();
+                    q.pop();
+                    if(nav_node->left != nullptr){
+                        q.push(nav_node->left);
+                    }
+                    if(nav_node->right != nullptr){
+                        q.push(nav_node->right);
+                    }
+                    node_allocator.destroy(nav_node);
                 }
-                delete nav_node;
             }
+            node_allocator.release();
             this->root = nullptr;
+            this->leftmost = nullptr;
+            this->rightmost = nullptr;
             this->node_count = 0;
         }
 
@@ -606,15 +661,46 @@ class Treap{
             return const_iterator(this, potential_succ);
         }
 
+        // Inclusive [lo, hi], f(key, value) in ascending key order
+        template<typename Function>
+        void range_for_each(const Key& lo, const Key& hi, Function f) {
+            range_walk(lo, hi, [&f](Node* node) { f(node->data.first, node->data.second); });
+        }
+
+        template<typename Function>
+        void range_for_each(const Key& lo, const Key& hi, Function f) const {
+            range_walk(lo, hi, [&f](const Node* node) { f(node->data.first, node->data.second); });
+        }
+
+        size_t range_count(const Key& lo, const Key& hi) const {
+            return range_count(lo, hi, Order_Statistics_Tag{});
+        }
+
+        Value range_sum(const Key& lo, const Key& hi) const {
+            Value sum{};
+            range_walk(lo, hi, [&sum](const Node* node) { sum += node->data.second; });
+            return sum;
+        }
+
+        // Number of keys below key, O(log N) expected
+        size_t rank(const Key& key) const {
+            static_assert(ORDER_STATISTICS, "rank needs Treap<Key, Value, true>");
+            return subtree_rank<false>(this->root, key);
+        }
+
+        // The k-th smallest entry (0-based), end() when k >= size()
+        iterator select(size_t k) {
+            static_assert(ORDER_STATISTICS, "select needs Treap<Key, Value, true>");
+            return iterator(this, subtree_select(this->root, k));
+        }
+
+        const_iterator select(size_t k) const {
+            static_assert(ORDER_STATISTICS, "select needs Treap<Key, Value, true>");
+            return const_iterator(this, subtree_select(this->root, k));
+        }
+
         iterator begin() {
-            // Find the minimum node (go left as far as possible)
-            Node* min_node = root;
-            if (min_node != nullptr) {
-                while (min_node->left != nullptr) {
-                    min_node = min_node->left;
-                }
-            }
-            return iterator(this, min_node);
+            return iterator(this, this->leftmost);
         }
 
         iterator end() {
@@ -622,13 +708,7 @@ class Treap{
         }
 
         const_iterator begin() const {
-            Node* min_node = root;
-            if (min_node != nullptr) {
-                while (min_node->left != nullptr) {
-                    min_node = min_node->left;
-                }
-            }
-            return const_iterator(this, min_node);
+            return const_iterator(this, this->leftmost);
         }
 
         const_iterator end() const {
@@ -0,0 +1,671 @@
+//
+// Batch_List with an unrolled node layout: every node (chunk) holds a small sorted array of pairs
+//
+
+#ifndef UNROLLED_BATCH_LIST_H
+#define UNROLLED_BATCH_LIST_H
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "Node_Pool.h"
+#include "Radix_Sort.h"
+
+// Pairs per chunk; 16-64 keeps a chunk of small pairs within a few cache lines
+const size_t UNROLLED_CHUNK_CAPACITY = 32;
+
+/*
+    Same interface as Batch_List, but a chunk stores up to CHUNK_CAPACITY pairs instead of one:
+        - keys are sorted across the whole chain, so scans read a contiguous array between pointer hops
+        - inserts are buffered in a vector, radix sorted together and merged into the chunks on the next read
+        - a full chunk splits in half; a chunk that drops below MIN_FILL merges with or borrows from a neighbour
+    Iterators are (chunk, index) pairs and are invalidated by any insert or erase.
+*/
+template<typename Key, typename Value, size_t CHUNK_CAPACITY = UNROLLED_CHUNK_CAPACITY>
+class Unrolled_Batch_List {
+    static_assert(CHUNK_CAPACITY >= 4, "Unrolled_Batch_List chunks need room for at least 4 pairs.");
+    public:
+        using Pair = std::pair<Key, Value>;
+    private:
+        struct Chunk {
+            Pair items[CHUNK_CAPACITY];
+            size_t count = 0;
+            Chunk* next = nullptr;
+            Chunk* prev = nullptr;
+        };
+
+        // Every chunk but the last holds at least MIN_FILL pairs; a repacking merge fills chunks to REBUILD_FILL
+        static constexpr size_t MIN_FILL = CHUNK_CAPACITY / 4;
+        static constexpr size_t REBUILD_FILL = CHUNK_CAPACITY - CHUNK_CAPACITY / 4;
+
+        Chunk* head = nullptr;
+        Chunk* tail = nullptr;
+        size_t pair_count = 0;
+        // Inserts not merged into the chunks yet, in arrival order
+        std::vector<Pair> pending;
+        Node_Pool<Chunk> chunk_allocator;
+
+    public:
+        template<bool IS_CONST>
+        class basic_iterator {
+            using Chunk_Type = typename std::conditional<IS_CONST, const Chunk, Chunk>::type;
+
+            public:
+            using iterator_category = std::bidirectional_iterator_tag;
+            using difference_type   = std::ptrdiff_t;
+            using value_type        = Pair;
+            using pointer           = typename std::conditional<IS_CONST, const Pair*, Pair*>::type;
+            using reference         = typename std::conditional<IS_CONST, const Pair&, Pair&>::type;
+
+            private:
+            Chunk_Type* chunk;
+            size_t index;
+
+            basic_iterator(Chunk_Type* chunk, size_t index) : chunk(chunk), index(index) {}
+
+            friend class Unrolled_Batch_List;
+            template<bool> friend class basic_iterator;
+
+            public:
+            basic_iterator() : chunk(nullptr), index(0) {}
+
+            // Converting constructor from non-const iterator
+            template<bool OTHER_CONST, typename = std::enable_if_t<IS_CONST and not OTHER_CONST>>
+            basic_iterator(const basic_iterator<OTHER_CONST>& other) : chunk(other.chunk), index(other.index) {}
+
+            reference operator*() const {
+                return chunk->items[index];
+            }
+
+            pointer operator->() const {
+                return &chunk->items[index];
+            }
+
+            // Steps inside the chunk array and only follows a pointer at either end of it; end() is (nullptr, 0)
+            basic_iterator& operator++() {
+                if (chunk != nullptr and ++index == chunk->count) {
+                    chunk = chunk->next;
+                    index = 0;
+                }
+                return *this;
+            }
+
+            basic_iterator operator++(int) {
+                basic_iterator old = *this;
+                ++(*this);
+                return old;
+            }
+
+            basic_iterator& operator--() {
+                if (chunk == nullptr) return *this;
+                if (index == 0) {
+                    chunk = chunk->prev;
+                    index = chunk == nullptr ? 0 : chunk->count - 1;
+                }
+                else {
+                    --index;
+                }
+                return *this;
+            }
+
+            basic_iterator operator--(int) {
+                basic_iterator old = *this;
+                --(*this);
+                return old;
+            }
+
+            template<bool OTHER_CONST>
+            bool operator==(const basic_iterator<OTHER_CONST>& other) const {
+                return chunk == other.chunk and index == other.index;
+            }
+
+            template<bool OTHER_CONST>
+            bool operator!=(const basic_iterator<OTHER_CONST>& other) const {
+                return !(*this == other);
+            }
+        };
+
+        using iterator = basic_iterator<false>;
+        using const_iterator = basic_iterator<true>;
+
+    private:
+        // True while a key lies before the bound: below key, or (OR_EQUAL) not above it
+        template<bool OR_EQUAL>
+        static bool before_bound(const Key& item_key, const Key& key) {
+            return item_key < key or (OR_EQUAL and not (key < item_key));
+        }
+
+        // Binary search inside one chunk, from a starting index
+        template<bool OR_EQUAL>
+        static size_t chunk_bound(const Chunk* chunk, size_t from, const Key& key) {
+            return std::partition_point(chunk->items + from, chunk->items + chunk->count,
+                [&key](const Pair& pair) { return before_bound<OR_EQUAL>(pair.first, key); }) - chunk->items;
+        }
+
+        // Moves a sweep cursor forward to the first pair at or past the bound: whole chunks are skipped by their
+        // last key, then one chunk is binary searched. Batch sweeps call it with ascending keys
+        template<bool OR_EQUAL>
+        static void advance_cursor(Chunk*& chunk, size_t& index, const Key& key) {
+            while (chunk != nullptr and before_bound<OR_EQUAL>(chunk->items[chunk->count - 1].first, key)) {
+                chunk = chunk->next;
+                index = 0;
+            }
+            if (chunk != nullptr) {
+                index = chunk_bound<OR_EQUAL>(chunk, index, key);
+            }
+        }
+
+        template<bool OR_EQUAL>
+        iterator bound(const Key& key) {
+            this->sort_keys();
+            Chunk* chunk = head;
+            size_t index = 0;
+            advance_cursor<OR_EQUAL>(chunk, index, key);
+            return iterator(chunk, index);
+        }
+
+        // The pair before (chunk, index), end() if there is none
+        iterator previous_position(Chunk* chunk, size_t index) {
+            if (chunk == nullptr) {
+                return tail == nullptr ? this->end() : iterator(tail, tail->count - 1);
+            }
+            if (index > 0) {
+                return iterator(chunk, index - 1);
+            }
+            return chunk->prev == nullptr ? this->end() : iterator(chunk->prev, chunk->prev->count - 1);
+        }
+
+        // Links a new empty chunk after chunk, or at the head when chunk is nullptr
+        Chunk* new_chunk_after(Chunk* chunk) {
+            Chunk* created = chunk_allocator.create();
+            created->prev = chunk;
+            created->next = chunk == nullptr ? head : chunk->next;
+            if (created->next != nullptr) {
+                created->next->prev = created;
+            }
+            else {
+                tail = created;
+            }
+            if (chunk != nullptr) {
+                chunk->next = created;
+            }
+            else {
+                head = created;
+            }
+            return created;
+        }
+
+        void unlink_chunk(Chunk* chunk) {
+            if (chunk->prev != nullptr) {
+                chunk->prev->next = chunk->next;
+            }
+            else {
+                head = chunk->next;
+            }
+            if (chunk->next != nullptr) {
+                chunk->next->prev = chunk->prev;
+            }
+            else {
+                tail = chunk->prev;
+            }
+            chunk_allocator.destroy(chunk);
+        }
+
+        // Moves the upper half of a full chunk into a new chunk after it
+        Chunk* split_chunk(Chunk* chunk) {
+            Chunk* upper = new_chunk_after(chunk);
+            size_t keep = chunk->count / 2;
+            std::move(chunk->items + keep, chunk->items + chunk->count, upper->items);
+            upper->count = chunk->count - keep;
+            chunk->count = keep;
+            return upper;
+        }
+
+        // Neighbours where one is under MIN_FILL: merge them when they fit in one chunk, otherwise even out
+        // the counts. Returns true when right was merged into left and freed
+        bool balance_neighbours(Chunk* left, Chunk* right) {
+            if (left->count + right->count <= CHUNK_CAPACITY) {
+                std::move(right->items, right->items + right->count, left->items + left->count);
+                left->count += right->count;
+                unlink_chunk(right);
+                return true;
+            }
+            size_t left_target = (left->count + right->count) / 2;
+            if (left->count < left_target) {
+                size_t moved = left_target - left->count;
+                std::move(right->items, right->items + moved, left->items + left->count);
+                std::move(right->items + moved, right->items + right->count, right->items);
+                right->count -= moved;
+            }
+            else {
+                size_t moved = left->count - left_target;
+                std::move_backward(right->items, right->items + right->count, right->items + right->count + moved);
+                std::move(left->items + left_target, left->items + left->count, right->items);
+                right->count += moved;
+            }
+            left->count = left_target;
+            return false;
+        }
+
+        // Removes one pair and returns the position of the pair after it, following any merge or borrow
+        iterator erase_at(Chunk* chunk, size_t index) {
+            std::move(chunk->items + index + 1, chunk->items + chunk->count, chunk->items + index);
+            --chunk->count;
+            --pair_count;
+            Chunk* next_chunk = index < chunk->count ? chunk : chunk->next;
+            size_t next_index = index < chunk->count ? index : 0;
+            if (chunk->count == 0) {
+                unlink_chunk(chunk);
+                return iterator(next_chunk, next_index);
+            }
+            Chunk* left = chunk->next != nullptr ? chunk : chunk->prev;
+            if (chunk->count >= MIN_FILL or left == nullptr) {
+                return iterator(next_chunk, next_index);
+            }
+
+            // next_chunk is left, right, or nullptr when chunk was the tail
+            size_t offset = next_chunk == left ? next_index : left->count + next_index;
+            bool merged = balance_neighbours(left, left->next);
+            if (next_chunk == nullptr) {
+                return this->end();
+            }
+            if (merged or offset < left->count) {
+                return iterator(left, offset);
+            }
+            return iterator(left->next, offset - left->count);
+        }
+
+        // One pass that merges or evens out every neighbour pair with a chunk under MIN_FILL
+        void coalesce_chunks() {
+            Chunk* chunk = head;
+            while (chunk != nullptr and chunk->next != nullptr) {
+                if ((chunk->count < MIN_FILL or chunk->next->count < MIN_FILL) and balance_neighbours(chunk, chunk->next)) {
+                    continue;
+                }
+                chunk = chunk->next;
+            }
+        }
+
+        // Pending pairs go one by one into the chunk whose range covers them, splitting full chunks.
+        // The cursor only moves forward: O(chunks + new * CHUNK_CAPACITY)
+        void insert_merge() {
+            Chunk* chunk = head;
+            for (Pair& pair : pending) {
+                while (chunk->next != nullptr and not (pair.first < chunk->items[chunk->count - 1].first)) {
+                    chunk = chunk->next;
+                }
+                if (chunk->count == CHUNK_CAPACITY) {
+                    Chunk* upper = split_chunk(chunk);
+                    if (not (pair.first < upper->items[0].first)) {
+                        chunk = upper;
+                    }
+                }
+                size_t pos = chunk_bound<true>(chunk, 0, pair.first);
+                std::move_backward(chunk->items + pos, chunk->items + chunk->count, chunk->items + chunk->count + 1);
+                chunk->items[pos] = std::move(pair);
+                ++chunk->count;
+            }
+            pair_count += pending.size();
+        }
+
+        // Linear merge of the chunk chain and the pending run into freshly packed chunks; drained chunks are freed
+        // as the merge leaves them, so the pool hands them straight back: O(N + new)
+        void rebuild_merge() {
+            Chunk* old_chunk = head;
+            size_t old_index = 0;
+            head = tail = nullptr;
+            auto emit = [this](Pair& pair) {
+                if (tail == nullptr or tail->count == REBUILD_FILL) {
+                    new_chunk_after(tail);
+                }
+                tail->items[tail->count++] = std::move(pair);
+            };
+
+            size_t pending_pos = 0;
+            while (old_chunk != nullptr or pending_pos < pending.size()) {
+                // Equal keys keep the older pair first
+                if (old_chunk != nullptr and (pending_pos == pending.size() or
+                        not (pending[pending_pos].first < old_chunk->items[old_index].first))) {
+                    emit(old_chunk->items[old_index]);
+                    if (++old_index == old_chunk->count) {
+                        Chunk* next_chunk = old_chunk->next;
+                        chunk_allocator.destroy(old_chunk);
+                        old_chunk = next_chunk;
+                        old_index = 0;
+                    }
+                }
+                else {
+                    emit(pending[pending_pos++]);
+                }
+            }
+            pair_count += pending.size();
+        }
+
+        // Merges the sorted pending run: large runs repack every chunk, small ones are inserted in place
+        void merge_pending() {
+            if (pending.empty()) return;
+
+            if (head == nullptr or pending.size() * CHUNK_CAPACITY >= pair_count) {
+                rebuild_merge();
+            }
+            else {
+                insert_merge();
+            }
+            pending.clear();
+        }
+
+    public:
+        // Radix sorts the pending pairs as one contiguous run, then merges them in; a clean list returns immediately.
+        // Call it before iterating through a const reference, const reads never merge
+        void sort_keys() {
+            if (pending.empty()) return;
+
+            radix_sort(pending.begin(), pending.end(), [](const Pair& pair) { return pair.first; });
+            merge_pending();
+        }
+
+        Unrolled_Batch_List() = default;
+
+        // Copies merge the pending inserts they take over, so a const list never has any to sort
+        Unrolled_Batch_List(const Unrolled_Batch_List& other) : pending(other.pending) {
+            for (const Chunk* chunk = other.head; chunk != nullptr; chunk = chunk->next) {
+                Chunk* copy = new_chunk_after(tail);
+                std::copy(chunk->items, chunk->items + chunk->count, copy->items);
+                copy->count = chunk->count;
+            }
+            pair_count = other.pair_count;
+            this->sort_keys();
+        }
+
+        Unrolled_Batch_List& operator=(const Unrolled_Batch_List& other) {
+            if (this != &other) {
+                clear();
+                for (const Chunk* chunk = other.head; chunk != nullptr; chunk = chunk->next) {
+                    Chunk* copy = new_chunk_after(tail);
+                    std::copy(chunk->items, chunk->items + chunk->count, copy->items);
+                    copy->count = chunk->count;
+                }
+                pair_count = other.pair_count;
+                pending = other.pending;
+                this->sort_keys();
+            }
+            return *this;
+        }
+
+        ~Unrolled_Batch_List() {
+            clear();
+        }
+
+        size_t size() const {
+            return pair_count + pending.size();
+        }
+
+        bool empty() const {
+            return size() == 0;
+        }
+
+        size_t chunk_count() const {
+            size_t chunks = 0;
+            for (const Chunk* chunk = head; chunk != nullptr; chunk = chunk->next) {
+                ++chunks;
+            }
+            return chunks;
+        }
+
+        // O(1): the pair waits in the pending run until a read needs the order
+        void insert(const Pair& map_pair) {
+            pending.push_back(map_pair);
+        }
+
+        void insert(const Key& key, const Value& value) {
+            pending.emplace_back(key, value);
+        }
+
+        // Iteration sees sorted order, pending inserts are merged first
+        iterator begin() {
+            this->sort_keys();
+            return iterator(head, 0);
+        }
+
+        iterator end() {
+            return iterator(nullptr, 0);
+        }
+
+        // Read-only: throws while inserts are pending instead of merging them, so const reads never write
+        const_iterator begin() const {
+            if (not pending.empty()) {
+                throw std::logic_error("Unrolled_Batch_List has pending inserts, call sort_keys() first!");
+            }
+            return const_iterator(head, 0);
+        }
+
+        const_iterator end() const {
+            return const_iterator(nullptr, 0);
+        }
+
+        const_iterator cbegin() const {
+            return this->begin();
+        }
+
+        const_iterator cend() const {
+            return this->end();
+        }
+
+        void clear() {
+            // Trivially destructible chunks go back with their slabs, no walk needed
+            if (!Node_Pool<Chunk>::BULK_RELEASE) {
+                Chunk* chunk = head;
+                while (chunk != nullptr) {
+                    Chunk* next_chunk = chunk->next;
+                    chunk_allocator.destroy(chunk);
+                    chunk = next_chunk;
+                }
+            }
+            chunk_allocator.release();
+            head = nullptr;
+            tail = nullptr;
+            pair_count = 0;
+            pending.clear();
+        }
+
+        // Point lookups walk chunk by chunk and binary search one chunk, O(N / CHUNK_CAPACITY + log CHUNK_CAPACITY)
+        iterator find(const Key& key) {
+            iterator found = bound<false>(key);
+            if (found != this->end() and found->first == key) {
+                return found;
+            }
+            return this->end();
+        }
+
+        iterator predecessor(const Key& key) {
+            iterator found = bound<false>(key);
+            return previous_position(found.chunk, found.index);
+        }
+
+        iterator successor(const Key& key) {
+            return bound<true>(key);
+        }
+
+        iterator erase(iterator pos) {
+            if (pos.chunk == nullptr) return this->end();
+            return erase_at(pos.chunk, pos.index);
+        }
+
+        // Erases every pair with key
+        void erase_key(const Key& key) {
+            iterator curr = bound<false>(key);
+            while (curr != this->end() and curr->first == key) {
+                curr = erase_at(curr.chunk, curr.index);
+            }
+        }
+
+        // Same rules as Batch_List::batch_insert: keys already in the list keep their value and repeats inside
+        // the batch keep their first occurrence. The sorted batch is filtered by one cursor sweep, then merged
+        template<typename InputIter>
+        void batch_insert(InputIter begin, InputIter end) {
+            this->sort_keys();
+            pending.assign(begin, end);
+            if (pending.empty()) return;
+
+            radix_sort(pending.begin(), pending.end(), [](const Pair& pair) { return pair.first; });
+            auto last = std::unique(pending.begin(), pending.end(),
+                [](const Pair& a, const Pair& b) { return a.first == b.first; });
+            pending.erase(last, pending.end());
+
+            Chunk* chunk = head;
+            size_t index = 0;
+            size_t new_count = 0;
+            for (size_t i = 0; i < pending.size(); ++i) {
+                advance_cursor<false>(chunk, index, pending[i].first);
+                if (chunk != nullptr and chunk->items[index].first == pending[i].first) continue;
+                if (new_count != i) {
+                    pending[new_count] = std::move(pending[i]);
+                }
+                ++new_count;
+            }
+            pending.erase(pending.begin() + new_count, pending.end());
+            merge_pending();
+        }
+
+        void batch_insert(const std::vector<Pair>& pairs) {
+            batch_insert(pairs.begin(), pairs.end());
+        }
+
+        // Batch lookups sort the probes and sweep one cursor across the chunks, results follow the sorted probes
+        std::vector<iterator> batch_find(std::vector<Key> keys) {
+            this->sort_keys();
+            radix_sort(keys.begin(), keys.end(), [](const Key& key) { return key; });
+
+            std::vector<iterator> results;
+            results.reserve(keys.size());
+
+            Chunk* chunk = head;
+            size_t index = 0;
+            for (size_t i = 0; i < keys.size(); i++) {
+                advance_cursor<false>(chunk, index, keys[i]);
+                if (chunk != nullptr and chunk->items[index].first == keys[i]) {
+                    results.push_back(iterator(chunk, index)); // Found key
+                }
+                else {
+                    results.push_back(this->end()); // Didn't find key
+                }
+            }
+            return results;
+        }
+
+        std::vector<iterator> batch_predecessors(std::vector<Key> keys) {
+            this->sort_keys();
+            radix_sort(keys.begin(), keys.end(), [](const Key& key) { return key; });
+
+            std::vector<iterator> results;
+            results.reserve(keys.size());
+
+            Chunk* chunk = head;
+            size_t index = 0;
+            for (size_t i = 0; i < keys.size(); i++) {
+                advance_cursor<false>(chunk, index, keys[i]);
+                results.push_back(previous_position(chunk, index));
+            }
+            return results;
+        }
+
+        std::vector<iterator> batch_successors(std::vector<Key> keys) {
+            this->sort_keys();
+            radix_sort(keys.begin(), keys.end(), [](const Key& key) { return key; });
+
+            std::vector<iterator> results;
+            results.reserve(keys.size());
+
+            Chunk* chunk = head;
+            size_t index = 0;
+            for (size_t i = 0; i < keys.size(); i++) {
+                advance_cursor<true>(chunk, index, keys[i]);
+                results.push_back(iterator(chunk, index));
+            }
+            return results;
+        }
+
+        // Inclusive [lo, hi]: find lo, then visit each chunk's array until a key passes hi
+        template<typename Function>
+        void range_for_each(const Key& lo, const Key& hi, Function f) {
+            iterator start = bound<false>(lo);
+            size_t index = start.index;
+            for (Chunk* chunk = start.chunk; chunk != nullptr; chunk = chunk->next, index = 0) {
+                for (; index < chunk->count; ++index) {
+                    if (hi < chunk->items[index].first) return;
+                    f(chunk->items[index].first, chunk->items[index].second);
+                }
+            }
+        }
+
+        // Chunks that end at or below hi are counted whole
+        size_t range_count(const Key& lo, const Key& hi) {
+            iterator start = bound<false>(lo);
+            size_t count = 0;
+            size_t index = start.index;
+            for (Chunk* chunk = start.chunk; chunk != nullptr; chunk = chunk->next, index = 0) {
+                if (hi < chunk->items[chunk->count - 1].first) {
+                    return count + chunk_bound<true>(chunk, index, hi) - index;
+                }
+                count += chunk->count - index;
+            }
+            return count;
+        }
+
+        Value range_sum(const Key& lo, const Key& hi) {
+            Value sum{};
+            range_for_each(lo, hi, [&sum](const Key&, const Value& value) { sum += value; });
+            return sum;
+        }
+
+        // Erases one pair per listed key (the oldest of a repeated key) like Batch_List::batch_erase: each chunk
+        // is compacted in place in one sweep, then underfilled neighbours are merged in a second pass over the chain
+        template<typename InputIter>
+        void batch_erase(InputIter begin, InputIter end) {
+            std::vector<Key> keys2erase(begin, end);
+            if (keys2erase.empty()) return;
+
+            this->sort_keys();
+            radix_sort(keys2erase.begin(), keys2erase.end(), [](const Key& key) { return key; });
+
+            // Remove duplicates
+            auto last = std::unique(keys2erase.begin(), keys2erase.end());
+            keys2erase.erase(last, keys2erase.end());
+
+            auto key_it = keys2erase.begin();
+            Chunk* chunk = head;
+            while (chunk != nullptr and key_it != keys2erase.end()) {
+                size_t kept = 0;
+                for (size_t i = 0; i < chunk->count; ++i) {
+                    while (key_it != keys2erase.end() and *key_it < chunk->items[i].first) {
+                        ++key_it;
+                    }
+                    if (key_it != keys2erase.end() and *key_it == chunk->items[i].first) {
+                        ++key_it;
+                        continue;
+                    }
+                    if (kept != i) {
+                        chunk->items[kept] = std::move(chunk->items[i]);
+                    }
+                    ++kept;
+                }
+                pair_count -= chunk->count - kept;
+                chunk->count = kept;
+
+                Chunk* next_chunk = chunk->next;
+                if (kept == 0) {
+                    unlink_chunk(chunk);
+                }
+                chunk = next_chunk;
+            }
+            coalesce_chunks();
+        }
+
+        void batch_erase(const std::vector<Key>& keys) {
+            batch_erase(keys.begin(), keys.end());
+        }
+};
+#endif //UNROLLED_BATCH_LIST_H
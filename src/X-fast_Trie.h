@@ -476,6 +476,43 @@ class XFastTrie{
 			return const_iterator(successorInternal(key2Internal(key)));
 		}
 
+		// Inclusive [lo, hi]: one trie descent to the first leaf >= lo, then a walk along the linked leaves
+		template<typename Function>
+		void range_for_each(const Key& lo, const Key& hi, Function f) {
+			if (hi < lo) return;
+			const size_t internal_lo = key2Internal(lo), internal_hi = key2Internal(hi);
+			iter_lowest_level leaf = lowest_level.find(internal_lo);
+			if (leaf == lowest_level.end()) leaf = successorInternal(internal_lo);
+			while (leaf != lowest_level.end() and leaf.key() <= internal_hi) {
+				f(internal2Key(leaf.key()), leaf->second);
+				++leaf;
+			}
+		}
+
+		template<typename Function>
+		void range_for_each(const Key& lo, const Key& hi, Function f) const {
+			if (hi < lo) return;
+			const size_t internal_lo = key2Internal(lo), internal_hi = key2Internal(hi);
+			const_iter_lowest_level leaf = lowest_level.find(internal_lo);
+			if (leaf == lowest_level.cend()) leaf = successorInternal(internal_lo);
+			while (leaf != lowest_level.cend() and leaf.key() <= internal_hi) {
+				f(internal2Key(leaf.key()), leaf->second);
+				++leaf;
+			}
+		}
+
+		size_t range_count(const Key& lo, const Key& hi) const {
+			size_t count = 0;
+			range_for_each(lo, hi, [&count](const Key&, const Value&) { ++count; });
+			return count;
+		}
+
+		Value range_sum(const Key& lo, const Key& hi) const {
+			Value sum{};
+			range_for_each(lo, hi, [&sum](const Key&, const Value& value) { sum += value; });
+			return sum;
+		}
+
         size_t findLongestCommonPrefixLevelIndex(const size_t& key){
 			size_t target_prefix_level_i = NULL_KEY;
             size_t low = 0;
@@ -0,0 +1,135 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <random>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#include "AVL_Tree.h"
+#include "Radix_Flat_Map.h"
+#include <Treap.h>
+
+#include "RandomDatasetGenerator.h"
+using namespace std;
+
+/*
+    Replaces the global operator new to count every allocation and the live and peak bytes, so it lives in
+    its own executable instead of changing the allocator under the other tests and Catch2.
+    (kept out of line so GCC does not pair the inlined malloc/free against new/delete)
+*/
+#if defined(__GNUC__)
+#define TEST_NOINLINE __attribute__((noinline))
+#else
+#define TEST_NOINLINE
+#endif
+static std::atomic<size_t> global_allocation_count(0);
+static std::atomic<size_t> global_live_bytes(0);
+static std::atomic<size_t> global_peak_bytes(0);
+
+// Every block starts with its size, padded to keep the returned pointer max-aligned
+constexpr size_t ALLOCATION_HEADER = alignof(std::max_align_t);
+
+TEST_NOINLINE void* operator new(size_t size) {
+	++global_allocation_count;
+	void* block = std::malloc(size + ALLOCATION_HEADER);
+	if(block == nullptr) throw std::bad_alloc();
+	*static_cast<size_t*>(block) = size;
+	size_t live = global_live_bytes += size;
+	size_t peak = global_peak_bytes;
+	while(live > peak and !global_peak_bytes.compare_exchange_weak(peak, live)) {}
+	return static_cast<char*>(block) + ALLOCATION_HEADER;
+}
+
+TEST_NOINLINE void* operator new(size_t size, const std::nothrow_t&) noexcept {
+	try {
+		return operator new(size);
+	}
+	catch(...) {
+		return nullptr;
+	}
+}
+
+TEST_NOINLINE void operator delete(void* ptr) noexcept {
+	if(ptr == nullptr) return;
+	void* block = static_cast<char*>(ptr) - ALLOCATION_HEADER;
+	global_live_bytes -= *static_cast<size_t*>(block);
+	std::free(block);
+}
+
+TEST_NOINLINE void operator delete(void* ptr, size_t) noexcept {
+	operator delete(ptr);
+}
+
+TEST_CASE("Tree insert and erase allocate nothing in steady state", "[node_pool][allocations]") {
+	size_t N = 100000;
+	RandomDatasetGenerator rdg(N);
+	std::vector<size_t> keys(rdg.random_size_ts.begin(), rdg.random_size_ts.end());
+	std::sort(keys.begin(), keys.end());
+	keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+	std::shuffle(keys.begin(), keys.end(), std::mt19937(7));
+
+	AVL_Tree<size_t, int> avl_tree;
+	AVL_Tree<size_t, int, true> avl_order_statistics;
+	Treap<size_t, int> treap;
+	auto churn = [&keys](auto& tree, const char* name) {
+		// Warm up: fill the tree, then churn once so the node pool's freelist covers every later insert
+		for(size_t key : keys) tree.insert(key, 1);
+		for(size_t key : keys) tree.erase(key);
+		for(size_t key : keys) tree.insert(key, 1);
+
+		size_t before = global_allocation_count;
+		const auto start = chrono::high_resolution_clock::now();
+		for(size_t round = 0; round < 4; round++) {
+			for(size_t i = 0; i < keys.size(); i += 2) tree.erase(keys[i]);
+			for(size_t i = 0; i < keys.size(); i += 2) tree.insert(keys[i], 2);
+		}
+		const double elapsed = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+		size_t allocations = global_allocation_count - before;
+		size_t ops = 4 * keys.size();
+
+		cout << fixed << setprecision(1);
+		cout << "[" << name << " INSERT/ERASE] " << 1e9 * elapsed / ops << " ns/op, "
+			<< static_cast<double>(allocations) / ops << " allocations/op\n";
+		REQUIRE(allocations == 0);
+		REQUIRE(tree.size() == keys.size());
+	};
+	churn(avl_tree, "AVL");
+	churn(avl_order_statistics, "AVL ORDER STATISTICS");
+	churn(treap, "TREAP");
+
+	// Range walks keep their path in the same inline buffer
+	size_t before = global_allocation_count;
+	REQUIRE(avl_tree.range_count(keys[0], keys[0]) == 1);
+	REQUIRE(treap.range_count(keys[1], keys[1]) == 1);
+	REQUIRE(global_allocation_count == before);
+}
+
+TEST_CASE("Radix flat map in-place bulk load needs no memory beyond its arrays", "[radix_sort][allocations]") {
+	size_t N = size_t(1) << 20;
+	RandomDatasetGenerator rdg(N);
+	std::vector<std::pair<size_t, size_t>> batch;
+	for(size_t i = 0; i < N; i++) {
+		batch.emplace_back(rdg.random_size_ts[i], i);
+	}
+	const size_t array_bytes = N * (sizeof(size_t) + sizeof(Flat_Map_Slot<size_t>));
+
+	// Peak bytes allocated while loading an empty map, relative to the flat arrays it ends up with
+	auto load_peak = [&batch](Radix_Sort_Mode mode, const char* name) {
+		size_t live_before = global_live_bytes;
+		global_peak_bytes = live_before;
+		Radix_Flat_Map<size_t, size_t> rfm(batch.begin(), batch.end(), 1, mode);
+		size_t peak = global_peak_bytes - live_before;
+		REQUIRE(rfm.size() == batch.size());
+		cout << fixed << setprecision(2);
+		cout << "[FLAT MAP BULK LOAD " << name << "] peak " << static_cast<double>(peak) / (batch.size() * 16)
+			<< "x the 16-byte pairs\n";
+		return peak;
+	};
+	REQUIRE(load_peak(Radix_Sort_Mode::MSD_IN_PLACE, "MSD_IN_PLACE") == array_bytes);
+	REQUIRE(load_peak(Radix_Sort_Mode::LSD_BUFFERED, "LSD_BUFFERED") > array_bytes);
+}
@@ -4,11 +4,15 @@
 #include <iomanip>
 #include <algorithm>
 #include <random>
+#include <array>
+#include <list>
 
 
 //fastest single-threaded map candidates for all int and float types
 #include "Radix_Flat_Map.h" //fast with read-heavy workloads
 #include "Batch_N_Hash_List.h" //fast with write-heavy workloads or batch lookup only
+#include "Batch_List.h" //fast with write-heavy workloads or batch lookup only
+#include "Unrolled_Batch_List.h" //Batch_List with chunked nodes for faster scans
 #include <map> //best for abstract data types
 #include "X-fast_Trie.h" //best for mixed workloads
 #include "AVL_Tree.h" //could be better for abstract data types
@@ -1064,3 +1068,1333 @@ TEST_CASE("Hash Map AVL Tree N element int-key-sort test", "[sorting]") {
 	REQUIRE(iter == hm_avl_tree.end());
 	REQUIRE(is_sorted);
 }
+
+// RADIX SORT SECTION
+TEST_CASE("Radix sort digit widths match std::sort", "[radix_sort]") {
+	size_t N = 1000;
+	RandomDatasetGenerator rdg(N);
+
+	// Identical high bytes make most passes constant, so they get skipped
+	std::vector<size_t> dense_ids;
+	for(size_t i = 0; i < N; i++) {
+		dense_ids.push_back((size_t(0xABCD) << 48) | (rdg.random_size_ts[i] & 0xFFFFF));
+	}
+
+	std::vector<size_t> expected_ids = dense_ids;
+	std::sort(expected_ids.begin(), expected_ids.end());
+	std::vector<int> expected_ints = rdg.random_ints;
+	std::sort(expected_ints.begin(), expected_ints.end());
+
+	std::vector<size_t> ids_8 = dense_ids, ids_11 = dense_ids, ids_16 = dense_ids;
+	radix_sort(ids_8.begin(), ids_8.end());
+	radix_sort<11>(ids_11.begin(), ids_11.end());
+	radix_sort<16>(ids_16.begin(), ids_16.end());
+	REQUIRE(ids_8 == expected_ids);
+	REQUIRE(ids_11 == expected_ids);
+	REQUIRE(ids_16 == expected_ids);
+
+	std::vector<int> ints_11 = rdg.random_ints, ints_16 = rdg.random_ints;
+	radix_sort<11>(ints_11.begin(), ints_11.end());
+	radix_sort<16>(ints_16.begin(), ints_16.end());
+	REQUIRE(ints_11 == expected_ints);
+	REQUIRE(ints_16 == expected_ints);
+}
+
+TEST_CASE("Parallel radix sort matches a stable sort", "[radix_sort][parallel]") {
+	size_t N = PARALLEL_RADIX_SORT_MIN_SIZE * 4;
+	RandomDatasetGenerator rdg(N);
+
+	// Few distinct keys so stability is actually exercised
+	std::vector<std::pair<int, size_t>> pairs;
+	for(size_t i = 0; i < N; i++) {
+		pairs.emplace_back(rdg.random_ints[i] % 1000, i);
+	}
+	std::vector<std::pair<int, size_t>> expected = pairs;
+	std::stable_sort(expected.begin(), expected.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+	parallel_radix_sort(pairs.begin(), pairs.end(), [](const auto& p) { return p.first; }, 4);
+	REQUIRE(pairs == expected);
+
+	std::vector<std::pair<size_t, int>> map_data;
+	for(size_t i = 0; i < N; i++) {
+		map_data.emplace_back(rdg.random_size_ts[i], rdg.random_ints[i]);
+	}
+	Radix_Flat_Map<size_t, int> rfm(map_data.begin(), map_data.end(), 4);
+	std::map<size_t, int> stl_map(map_data.begin(), map_data.end());
+	REQUIRE(rfm.size() == stl_map.size());
+	REQUIRE(std::equal(rfm.begin(), rfm.end(), stl_map.begin(),
+		[](const auto& a, const auto& b) { return a.first == b.first and a.second == b.second; }));
+}
+
+TEST_CASE("In-place MSD radix sort matches std::sort", "[radix_sort][in_place]") {
+	size_t N = 5000;
+	RandomDatasetGenerator rdg(N);
+
+	std::vector<int> ints = rdg.random_ints;
+	std::vector<int> expected_ints = rdg.random_ints;
+	std::sort(expected_ints.begin(), expected_ints.end());
+	radix_sort(ints.begin(), ints.end(), [](int key) { return key; }, Radix_Sort_Mode::MSD_IN_PLACE);
+	REQUIRE(ints == expected_ints);
+
+	std::vector<std::pair<size_t, int>> map_data;
+	for(size_t i = 0; i < N; i++) {
+		map_data.emplace_back(rdg.random_size_ts[i] >> 40, rdg.random_ints[i]);
+	}
+	Radix_Flat_Map<size_t, int> rfm;
+	rfm.insert_batch(map_data.begin(), map_data.end(), 1, Radix_Sort_Mode::MSD_IN_PLACE);
+	std::set<size_t> expected_keys;
+	for(const auto& p : map_data) {
+		expected_keys.insert(p.first);
+	}
+	REQUIRE(rfm.size() == expected_keys.size());
+	REQUIRE(std::equal(rfm.begin(), rfm.end(), expected_keys.begin(),
+		[](const auto& p, size_t key) { return p.first == key; }));
+}
+
+TEST_CASE("Indirect radix sort matches a stable sort", "[radix_sort][indirect]") {
+	size_t N = 5000;
+	RandomDatasetGenerator rdg(N);
+
+	// Large payloads are what the indirect mode is for
+	std::vector<std::pair<int, std::vector<size_t>>> pairs;
+	for(size_t i = 0; i < N; i++) {
+		pairs.emplace_back(rdg.random_ints[i] % 100, std::vector<size_t>(4, i));
+	}
+	auto expected = pairs;
+	std::stable_sort(expected.begin(), expected.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+	radix_sort(pairs.begin(), pairs.end(), [](const auto& p) { return p.first; }, Radix_Sort_Mode::LSD_INDIRECT);
+	REQUIRE(pairs == expected);
+}
+
+TEST_CASE("Radix sort by key moves parallel value arrays with their keys", "[radix_sort][by_key]") {
+	size_t N = 5000;
+	RandomDatasetGenerator rdg(N);
+
+	std::vector<std::pair<int, std::string>> expected;
+	for(size_t i = 0; i < N; i++) {
+		expected.emplace_back(rdg.random_ints[i] % 100, std::to_string(i));
+	}
+	std::stable_sort(expected.begin(), expected.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+	// The LSD modes keep equal keys in input order, the in-place mode only keeps every key with its value
+	for(Radix_Sort_Mode mode : {Radix_Sort_Mode::LSD_BUFFERED, Radix_Sort_Mode::LSD_INDIRECT, Radix_Sort_Mode::MSD_IN_PLACE}) {
+		std::vector<int> keys;
+		std::vector<std::string> values;
+		for(size_t i = 0; i < N; i++) {
+			keys.push_back(rdg.random_ints[i] % 100);
+			values.push_back(std::to_string(i));
+		}
+		radix_sort_by_key(keys.begin(), keys.end(), values.begin(), mode, 2);
+		std::vector<std::pair<int, std::string>> sorted;
+		for(size_t i = 0; i < N; i++) {
+			sorted.emplace_back(keys[i], values[i]);
+		}
+		if(mode == Radix_Sort_Mode::MSD_IN_PLACE) {
+			REQUIRE(std::is_sorted(keys.begin(), keys.end()));
+			std::sort(sorted.begin(), sorted.end());
+			auto expected_pairs = expected;
+			std::sort(expected_pairs.begin(), expected_pairs.end());
+			REQUIRE(sorted == expected_pairs);
+		}
+		else {
+			REQUIRE(sorted == expected);
+		}
+	}
+
+	// Empty maps load the batch into their own arrays, repeats still follow the batch policy
+	std::list<std::pair<size_t, int>> batch;
+	std::map<size_t, int> expected_keep_old, expected_overwrite, expected_combine;
+	for(size_t i = 0; i < N; i++) {
+		size_t key = rdg.random_size_ts[i] % 1000;
+		batch.emplace_back(key, static_cast<int>(i));
+		expected_keep_old.emplace(key, static_cast<int>(i));
+		expected_overwrite[key] = static_cast<int>(i);
+		expected_combine[key] += static_cast<int>(i);
+	}
+	Radix_Flat_Map<size_t, int> keep_old(batch.begin(), batch.end());
+	Radix_Flat_Map<size_t, int> overwrite, combine;
+	overwrite.insert_or_assign_batch(batch.begin(), batch.end(), 1, Radix_Sort_Mode::LSD_INDIRECT);
+	combine.merge_batch(batch.begin(), batch.end(), [](int old_value, int new_value) { return old_value + new_value; });
+	auto same_pair = [](const auto& a, const auto& b) { return a.first == b.first and a.second == b.second; };
+	REQUIRE(std::equal(keep_old.begin(), keep_old.end(), expected_keep_old.begin(), expected_keep_old.end(), same_pair));
+	REQUIRE(std::equal(overwrite.begin(), overwrite.end(), expected_overwrite.begin(), expected_overwrite.end(), same_pair));
+	REQUIRE(std::equal(combine.begin(), combine.end(), expected_combine.begin(), expected_combine.end(), same_pair));
+	REQUIRE(keep_old.successor(500) - keep_old.begin() ==
+		std::distance(expected_keep_old.begin(), expected_keep_old.upper_bound(500)));
+}
+
+TEST_CASE("Radix sort floating-point, 128-bit and composite keys", "[radix_sort][key_traits]") {
+	size_t N = 1000;
+	RandomDatasetGenerator rdg(N);
+
+	std::vector<double> prices;
+	for(size_t i = 0; i < N; i++) {
+		prices.push_back(rdg.random_ints[i] / 1000.0);
+	}
+	prices.push_back(-0.0);
+	prices.push_back(std::numeric_limits<double>::infinity());
+	prices.push_back(-std::numeric_limits<double>::infinity());
+	std::vector<double> expected_prices = prices;
+	std::sort(expected_prices.begin(), expected_prices.end());
+	radix_sort(prices.begin(), prices.end());
+	REQUIRE(prices == expected_prices);
+
+#ifdef __SIZEOF_INT128__
+	std::vector<__int128> wide_ids;
+	for(size_t i = 0; i < N; i++) {
+		wide_ids.push_back((static_cast<__int128>(rdg.random_ints[i]) << 64) | rdg.random_size_ts[i]);
+	}
+	std::vector<__int128> expected_wide_ids = wide_ids;
+	std::sort(expected_wide_ids.begin(), expected_wide_ids.end());
+	radix_sort<11>(wide_ids.begin(), wide_ids.end());
+	REQUIRE(wide_ids == expected_wide_ids);
+#endif
+
+	// (tenant, id) composite keys through the containers
+	Radix_Flat_Map<std::pair<int, size_t>, int> rfm;
+	Batch_List<std::pair<int, size_t>, int> batch_list;
+	std::map<std::pair<int, size_t>, int> stl_map;
+	std::vector<std::pair<std::pair<int, size_t>, int>> batch;
+	for(size_t i = 0; i < N; i++) {
+		std::pair<int, size_t> key(rdg.random_ints[i] % 10, rdg.random_size_ts[i]);
+		batch.emplace_back(key, static_cast<int>(i));
+		stl_map.emplace(key, static_cast<int>(i));
+	}
+	rfm.insert_batch(batch.begin(), batch.end());
+	batch_list.batch_insert(batch.begin(), batch.end());
+	REQUIRE(rfm.size() == stl_map.size());
+	REQUIRE(std::equal(rfm.begin(), rfm.end(), stl_map.begin(),
+		[](const auto& a, const auto& b) { return a.first == b.first; }));
+	REQUIRE(std::equal(batch_list.begin(), batch_list.end(), stl_map.begin(),
+		[](const auto& a, const auto& b) { return a.first == b.first; }));
+}
+
+TEST_CASE("Radix flat map std::string keys", "[radix_sort][string]") {
+	size_t N = 2000;
+	RandomDatasetGenerator rdg(N);
+
+	// Long shared prefixes, embedded prefixes of other keys and empty strings
+	std::vector<std::pair<std::string, int>> batch;
+	for(size_t i = 0; i < N; i++) {
+		std::string name = (i % 3 == 0 ? "Adam" : "Adamson_the_third_") + std::to_string(rdg.random_size_ts[i] % 500);
+		batch.emplace_back(name.substr(0, rdg.random_size_ts[i] % (name.size() + 1)), rdg.random_ints[i]);
+	}
+
+	std::vector<std::pair<std::string, int>> sorted_batch = batch;
+	string_radix_sort(sorted_batch.begin(), sorted_batch.end(), [](const auto& p) -> const std::string& { return p.first; });
+	REQUIRE(std::is_sorted(sorted_batch.begin(), sorted_batch.end(), [](const auto& a, const auto& b) { return a.first < b.first; }));
+
+	Radix_Flat_Map<std::string, int> rfm(batch.begin(), batch.begin() + N / 2);
+	rfm.insert_batch(batch.begin() + N / 2, batch.end());
+	std::map<std::string, int> stl_map(batch.begin(), batch.end());
+	REQUIRE(rfm.size() == stl_map.size());
+	REQUIRE(std::equal(rfm.begin(), rfm.end(), stl_map.begin(),
+		[](const auto& a, const auto& b) { return a.first == b.first; }));
+
+	REQUIRE(rfm.insert("Adam!", 12345678));
+	REQUIRE(rfm.find("Adam!")->second == 12345678);
+	REQUIRE(rfm.successor("Adam!")->first == stl_map.upper_bound("Adam!")->first);
+	REQUIRE(rfm.predecessor("Adamson") != rfm.end());
+	REQUIRE(rfm.erase("Adam!"));
+	REQUIRE(rfm.find("Adam!") == rfm.end());
+
+	for(const auto& p : stl_map) {
+		REQUIRE(rfm.find(p.first) != rfm.end());
+	}
+
+	// Other layouts and the delta buffer work for strings too
+	const Radix_Flat_Map<std::string, int, Eytzinger_Search> eytzinger_rfm(batch.begin(), batch.end());
+	Radix_Flat_Map<std::string, int, S_Tree_Search> s_tree_rfm(batch.begin(), batch.end());
+	s_tree_rfm.insert("Adam!", 1);
+	REQUIRE(s_tree_rfm.erase("Adam!"));
+	for(const auto& p : stl_map) {
+		REQUIRE(eytzinger_rfm.count(p.first) == 1);
+		REQUIRE(s_tree_rfm.count(p.first) == 1);
+		REQUIRE(rfm.rank(p.first) == eytzinger_rfm.rank(p.first));
+	}
+	REQUIRE(eytzinger_rfm.count("Adam!") == 0);
+	REQUIRE(s_tree_rfm.count("Adam!") == 0);
+}
+
+TEST_CASE("Radix flat map batch merge duplicate policies", "[radix_sort][merge]") {
+	size_t N = 5000;
+	RandomDatasetGenerator rdg(N);
+
+	// Overlapping keys between the map, the batch and inside the batch
+	std::vector<std::pair<size_t, int>> base, batch;
+	for(size_t i = 0; i < N; i++) {
+		base.emplace_back(rdg.random_size_ts[i] % 4000, 1);
+		batch.emplace_back(rdg.random_size_ts[N - 1 - i] % 6000, 2);
+	}
+
+	Radix_Flat_Map<size_t, int> keep_old(base.begin(), base.end());
+	Radix_Flat_Map<size_t, int> overwrite(base.begin(), base.end());
+	Radix_Flat_Map<size_t, int> combine(base.begin(), base.end());
+	keep_old.insert_batch(batch.begin(), batch.end());
+	overwrite.insert_or_assign_batch(batch.begin(), batch.end());
+	combine.merge_batch(batch.begin(), batch.end(), [](int old_value, int new_value) { return old_value + new_value; });
+
+	std::map<size_t, int> expected_keep_old, expected_overwrite, expected_combine;
+	for(const auto& p : base) {
+		expected_keep_old.emplace(p.first, p.second);
+		expected_overwrite.emplace(p.first, p.second);
+		expected_combine.emplace(p.first, p.second);
+	}
+	for(const auto& p : batch) {
+		expected_keep_old.emplace(p.first, p.second);
+		expected_overwrite[p.first] = p.second;
+		auto it = expected_combine.find(p.first);
+		if(it == expected_combine.end()) expected_combine.emplace(p.first, p.second);
+		else it->second += p.second;
+	}
+
+	REQUIRE(keep_old.size() == expected_keep_old.size());
+	auto same_pair = [](const auto& a, const auto& b) { return a.first == b.first and a.second == b.second; };
+	REQUIRE(std::equal(keep_old.begin(), keep_old.end(), expected_keep_old.begin(), same_pair));
+	REQUIRE(std::equal(overwrite.begin(), overwrite.end(), expected_overwrite.begin(), same_pair));
+	REQUIRE(std::equal(combine.begin(), combine.end(), expected_combine.begin(), same_pair));
+
+	// Small batch into a large map, including keys below and above the current range
+	std::vector<std::pair<size_t, int>> small_batch = {{0, 7}, {3999, 7}, {100000, 7}, {100000, 8}};
+	overwrite.insert_or_assign_batch(small_batch.begin(), small_batch.end());
+	REQUIRE(overwrite.find(0)->second == 7);
+	REQUIRE(overwrite.find(100000)->second == 8);
+	REQUIRE(std::is_sorted(overwrite.begin(), overwrite.end(), [](const auto& a, const auto& b) { return a.first < b.first; }));
+
+	Radix_Flat_Map<std::string, int> string_rfm;
+	std::vector<std::pair<std::string, int>> names = {{"Bob", 1}, {"Al", 1}, {"Alexandria", 1}};
+	std::vector<std::pair<std::string, int>> more_names = {{"Alexandria", 2}, {"Alexander", 2}, {"", 2}};
+	string_rfm.insert_batch(names.begin(), names.end());
+	string_rfm.merge_batch(more_names.begin(), more_names.end(), [](int old_value, int new_value) { return old_value + new_value; });
+	REQUIRE(string_rfm.size() == 5);
+	REQUIRE(string_rfm.find("Alexandria")->second == 3);
+	REQUIRE(string_rfm.find("")->second == 2);
+	REQUIRE(string_rfm.successor("Al")->first == "Alexander");
+}
+
+TEST_CASE("Radix flat map search layouts", "[radix_sort][search]") {
+	// Sizes around the S-tree node and level boundaries (16 keys, 17 children)
+	for(size_t N : {10, 300, 5000, 10000}) {
+		RandomDatasetGenerator rdg(N);
+		std::vector<std::pair<int, int>> batch;
+		for(size_t i = 0; i < N; i++) {
+			batch.emplace_back(rdg.random_ints[i] % 50000, static_cast<int>(i));
+		}
+		std::vector<int> keys2erase(rdg.random_ints.begin(), rdg.random_ints.begin() + N / 20);
+
+		// Each layout answers like the binary-search map, also after single-key writes and batch rebuilds
+		auto check_layout = [&](auto empty_rfm) {
+			REQUIRE(empty_rfm.find(1) == empty_rfm.end());
+			REQUIRE(empty_rfm.successor(1) == empty_rfm.end());
+
+			decltype(empty_rfm) layout_rfm(batch.begin(), batch.end());
+			Radix_Flat_Map<int, int> binary_rfm(batch.begin(), batch.end());
+			REQUIRE(layout_rfm.size() == binary_rfm.size());
+
+			auto same_answers = [&]() {
+				for(int probe = -50001; probe <= 50001; probe += 7) {
+					REQUIRE((layout_rfm.find(probe) == layout_rfm.end()) == (binary_rfm.find(probe) == binary_rfm.end()));
+					REQUIRE(layout_rfm.predecessor(probe) - layout_rfm.begin() == binary_rfm.predecessor(probe) - binary_rfm.begin());
+					REQUIRE(layout_rfm.successor(probe) - layout_rfm.begin() == binary_rfm.successor(probe) - binary_rfm.begin());
+				}
+				for(auto it = binary_rfm.begin(); it != binary_rfm.end(); ++it) {
+					REQUIRE(layout_rfm.find(it->first) - layout_rfm.begin() == it - binary_rfm.begin());
+				}
+			};
+			same_answers();
+
+			// Stale copy after single-key writes, then rebuilt by a batch operation
+			for(int key = 0; key < 100; key++) {
+				layout_rfm.insert(key * 1000 + 1, key);
+				binary_rfm.insert(key * 1000 + 1, key);
+				layout_rfm.erase(key * 977);
+				binary_rfm.erase(key * 977);
+			}
+			same_answers();
+			layout_rfm.erase_batch(keys2erase.begin(), keys2erase.end());
+			binary_rfm.erase_batch(keys2erase.begin(), keys2erase.end());
+			same_answers();
+			layout_rfm.insert_batch(batch.begin(), batch.end());
+			binary_rfm.insert_batch(batch.begin(), batch.end());
+			same_answers();
+		};
+		check_layout(Radix_Flat_Map<int, int, Eytzinger_Search>());
+		check_layout(Radix_Flat_Map<int, int, S_Tree_Search>());
+		check_layout(Radix_Flat_Map<int, int, Learned_Search<>>());
+		check_layout(Radix_Flat_Map<int, int, Learned_Search<2>>());
+		check_layout(Radix_Flat_Map<int, int, Interpolation_Search>());
+		check_layout(Radix_Flat_Map<int, int, Galloping_Search>());
+	}
+
+	// Separators padded with the largest key work for keys without numeric_limits
+	std::vector<std::pair<std::pair<int, int>, int>> pairs;
+	for(int i = 0; i < 1000; i++) {
+		pairs.emplace_back(std::make_pair(i / 10, i % 10 * 2), i);
+	}
+	Radix_Flat_Map<std::pair<int, int>, int, S_Tree_Search> pair_rfm(pairs.begin(), pairs.end());
+	REQUIRE(pair_rfm.find(std::make_pair(57, 4))->second == 572);
+	REQUIRE(pair_rfm.find(std::make_pair(57, 3)) == pair_rfm.end());
+	REQUIRE(pair_rfm.successor(std::make_pair(57, 3))->second == 572);
+	REQUIRE(pair_rfm.predecessor(std::make_pair(57, 3))->second == 571);
+	REQUIRE(pair_rfm.successor(std::make_pair(99, 18)) == pair_rfm.end());
+	REQUIRE(pair_rfm.predecessor(std::make_pair(1000, 0))->second == 999);
+}
+
+TEST_CASE("Radix flat map learned search layout", "[radix_sort][search]") {
+	size_t N = 20000;
+	RandomDatasetGenerator rdg(N);
+
+	// Smooth 64-bit IDs with small random gaps, merged in batches
+	std::vector<std::pair<uint64_t, int>> ids;
+	uint64_t id = uint64_t(1) << 40;
+	for(size_t i = 0; i < N; i++) {
+		id += 1 + rdg.random_size_ts[i] % 16;
+		ids.emplace_back(id, static_cast<int>(i));
+	}
+	Radix_Flat_Map<uint64_t, int, Learned_Search<16>> learned_rfm(ids.begin(), ids.begin() + N / 2);
+	Radix_Flat_Map<uint64_t, int> binary_rfm(ids.begin(), ids.begin() + N / 2);
+	REQUIRE(learned_rfm.search_layout().max_error() <= 16 + 1);
+	REQUIRE(learned_rfm.search_layout().mean_error() <= 16);
+	REQUIRE(learned_rfm.search_layout().segment_count() < N / 100);
+	REQUIRE(learned_rfm.search_layout().memory_bytes() > 0);
+
+	// Refit from the first changed position: appends, a middle merge and erases
+	for(size_t begin = N / 2; begin < N; begin += N / 8) {
+		learned_rfm.insert_batch(ids.begin() + begin, ids.begin() + begin + N / 8);
+		binary_rfm.insert_batch(ids.begin() + begin, ids.begin() + begin + N / 8);
+	}
+	std::vector<std::pair<uint64_t, int>> middle = {{ids[N / 3].first + 1, -1}, {ids[N / 3].first - 1, -1}};
+	learned_rfm.insert_batch(middle.begin(), middle.end());
+	binary_rfm.insert_batch(middle.begin(), middle.end());
+	std::vector<uint64_t> keys2erase = {ids[N / 4].first, ids[N - 1].first, ids[N - 2].first};
+	learned_rfm.erase_batch(keys2erase.begin(), keys2erase.end());
+	binary_rfm.erase_batch(keys2erase.begin(), keys2erase.end());
+	REQUIRE(learned_rfm.search_layout().max_error() <= 16 + 1);
+
+	for(size_t i = 0; i < N; i += 3) {
+		uint64_t probe = ids[i].first + (i % 2);
+		REQUIRE(learned_rfm.find(probe) - learned_rfm.begin() == binary_rfm.find(probe) - binary_rfm.begin());
+		REQUIRE(learned_rfm.successor(probe) - learned_rfm.begin() == binary_rfm.successor(probe) - binary_rfm.begin());
+		REQUIRE(learned_rfm.predecessor(probe) - learned_rfm.begin() == binary_rfm.predecessor(probe) - binary_rfm.begin());
+	}
+	REQUIRE(learned_rfm.successor(0)->first == binary_rfm.begin()->first);
+	REQUIRE(learned_rfm.successor(std::numeric_limits<uint64_t>::max()) == learned_rfm.end());
+
+	// Floating-point keys
+	std::vector<std::pair<double, int>> doubles;
+	for(size_t i = 0; i < 1000; i++) {
+		doubles.emplace_back(std::sqrt(static_cast<double>(i)) - 10.0, static_cast<int>(i));
+	}
+	Radix_Flat_Map<double, int, Learned_Search<4>> double_rfm(doubles.begin(), doubles.end());
+	REQUIRE(double_rfm.find(std::sqrt(500.0) - 10.0)->second == 500);
+	REQUIRE(double_rfm.successor(-10.5)->second == 0);
+	REQUIRE(double_rfm.predecessor(0.0)->second == 99);
+}
+
+TEST_CASE("Radix flat map galloping from a hint", "[radix_sort][search]") {
+	size_t N = 5000;
+	RandomDatasetGenerator rdg(N);
+
+	std::vector<std::pair<size_t, int>> batch;
+	for(size_t i = 0; i < N; i++) {
+		batch.emplace_back(rdg.random_size_ts[i] % 100000, static_cast<int>(i));
+	}
+	Radix_Flat_Map<size_t, int> rfm(batch.begin(), batch.end());
+	std::vector<size_t> keys;
+	for(auto it = rfm.begin(); it != rfm.end(); ++it) keys.push_back(it->first);
+
+	// Every hint position, including end(), gives the unhinted answer
+	for(size_t hint = 0; hint <= keys.size(); hint += 37) {
+		for(size_t probe = 0; probe <= 100001; probe += 997) {
+			REQUIRE(flat_map_gallop<false>(probe, keys.data(), keys.size(), hint) ==
+				static_cast<size_t>(std::lower_bound(keys.begin(), keys.end(), probe) - keys.begin()));
+			REQUIRE(flat_map_gallop<true>(probe, keys.data(), keys.size(), hint) ==
+				static_cast<size_t>(std::upper_bound(keys.begin(), keys.end(), probe) - keys.begin()));
+		}
+	}
+
+	// Scan-then-probe: each successor starts from the previous answer
+	auto hint = rfm.cbegin();
+	for(size_t probe = 0; probe < 100000; probe += 50) {
+		auto it = rfm.successor(probe, hint);
+		REQUIRE(it == rfm.successor(probe));
+		REQUIRE(rfm.predecessor(probe, hint) == rfm.predecessor(probe));
+		REQUIRE(rfm.find(probe, hint) == rfm.find(probe));
+		if(it != rfm.end()) hint = it;
+	}
+
+	// The galloping layout remembers its last position across calls
+	Radix_Flat_Map<size_t, int, Galloping_Search> galloping_rfm(batch.begin(), batch.end());
+	for(size_t probe = 100000; probe >= 77; probe -= 77) {
+		REQUIRE(galloping_rfm.successor(probe) - galloping_rfm.begin() == rfm.successor(probe) - rfm.begin());
+	}
+}
+
+// Shared oracle: find, predecessor and successor agree with std::map for one probe key
+template<typename Map, typename Key, typename Value>
+void require_same_neighbours(Map& map, const std::map<Key, Value>& stl_map, const Key& key) {
+	REQUIRE((map.find(key) == map.end()) == (stl_map.count(key) == 0));
+	auto predecessor = map.predecessor(key);
+	auto stl_lower = stl_map.lower_bound(key);
+	REQUIRE((predecessor == map.end()) == (stl_lower == stl_map.begin()));
+	if(stl_lower != stl_map.begin()) REQUIRE(predecessor->first == std::prev(stl_lower)->first);
+	auto successor = map.successor(key);
+	auto stl_successor = stl_map.upper_bound(key);
+	REQUIRE((successor == map.end()) == (stl_successor == stl_map.end()));
+	if(stl_successor != stl_map.end()) REQUIRE(successor->first == stl_successor->first);
+}
+
+TEST_CASE("Radix flat map delta buffer for single-key writes", "[radix_sort][delta]") {
+	// Mixed single-key writes: inserts, erases, erase-then-reinsert and operator[] on every source
+	auto check_mixed_writes = [](auto rfm, size_t delta_limit) {
+		size_t N = 20000;
+		RandomDatasetGenerator rdg(N);
+		rfm.set_delta_limit(delta_limit);
+		std::map<size_t, int> stl_map;
+		for(size_t i = 0; i < N; i++) {
+			size_t key = rdg.random_size_ts[i] % 3000;
+			switch(i % 5) {
+				case 0:
+				case 1:
+					REQUIRE(rfm.insert(key, static_cast<int>(i)) == stl_map.emplace(key, static_cast<int>(i)).second);
+					break;
+				case 2:
+					REQUIRE(rfm.erase(key) == (stl_map.erase(key) == 1));
+					break;
+				case 3:
+					rfm[key] += 1;
+					stl_map[key] += 1;
+					break;
+				default:
+					REQUIRE(rfm.count(key) == stl_map.count(key));
+					break;
+			}
+			REQUIRE(rfm.size() == stl_map.size());
+			if(i % 997 == 0) {
+				auto it = rfm.find(key);
+				REQUIRE((it == rfm.end()) == (stl_map.count(key) == 0));
+			}
+		}
+
+		REQUIRE(std::equal(rfm.begin(), rfm.end(), stl_map.begin(),
+			[](const auto& a, const auto& b) { return a.first == b.first and a.second == b.second; }));
+		for(size_t probe = 0; probe < 3000; probe += 13) {
+			require_same_neighbours(rfm, stl_map, probe);
+		}
+	};
+	check_mixed_writes(Radix_Flat_Map<size_t, int>(), 0);
+	check_mixed_writes(Radix_Flat_Map<size_t, int>(), 1);
+	check_mixed_writes(Radix_Flat_Map<size_t, int>(), 7);
+	check_mixed_writes(Radix_Flat_Map<size_t, int, Eytzinger_Search>(), 0);
+	check_mixed_writes(Radix_Flat_Map<size_t, int, Learned_Search<8>>(), 16);
+
+	// Pending writes are visible to count and merged by batch operations
+	std::vector<std::pair<size_t, int>> batch = {{1, 1}, {3, 3}, {5, 5}};
+	Radix_Flat_Map<size_t, int> rfm(batch.begin(), batch.end());
+	rfm.insert(2, 2);
+	rfm.erase(3);
+	REQUIRE(rfm.count(2) == 1);
+	REQUIRE(rfm.count(3) == 0);
+	REQUIRE(rfm.size() == 3);
+	std::vector<std::pair<size_t, int>> more = {{3, 30}, {4, 4}};
+	rfm.insert_batch(more.begin(), more.end());
+	std::vector<size_t> erase_keys = {1};
+	rfm.erase_batch(erase_keys.begin(), erase_keys.end());
+	std::vector<std::pair<size_t, int>> expected = {{2, 2}, {3, 30}, {4, 4}, {5, 5}};
+	REQUIRE(std::equal(rfm.begin(), rfm.end(), expected.begin(), expected.end(),
+		[](const auto& a, const auto& b) { return a.first == b.first and a.second == b.second; }));
+
+	// Reads and iterators see pending writes in merged order without merging them
+	size_t N = 2000;
+	RandomDatasetGenerator rdg(N);
+	std::vector<std::pair<size_t, int>> base;
+	for(size_t i = 0; i < N; i++) {
+		base.emplace_back(rdg.random_size_ts[i] % 4000, rdg.random_ints[i]);
+	}
+	Radix_Flat_Map<size_t, int> pending_rfm(base.begin(), base.end());
+	std::map<size_t, int> stl_map(base.begin(), base.end());
+	pending_rfm.set_delta_limit(N);
+	for(size_t i = 0; i < N / 4; i++) {
+		size_t key = rdg.random_size_ts[N - 1 - i] % 4000;
+		if(i % 2 == 0) {
+			REQUIRE(pending_rfm.insert(key, static_cast<int>(i)) == stl_map.emplace(key, static_cast<int>(i)).second);
+		}
+		else {
+			REQUIRE(pending_rfm.erase(key) == (stl_map.erase(key) == 1));
+		}
+	}
+	const auto& const_rfm = pending_rfm;
+	REQUIRE(const_rfm.size() == stl_map.size());
+	REQUIRE(std::equal(const_rfm.begin(), const_rfm.end(), stl_map.begin(), stl_map.end(),
+		[](const auto& a, const auto& b) { return a.first == b.first and a.second == b.second; }));
+	REQUIRE(std::equal(std::make_reverse_iterator(const_rfm.end()), std::make_reverse_iterator(const_rfm.begin()), stl_map.rbegin(),
+		[](const auto& a, const auto& b) { return a.first == b.first; }));
+	auto stl_it = stl_map.begin();
+	for(size_t k = 0; k < stl_map.size(); k++, ++stl_it) {
+		REQUIRE(const_rfm.select(k)->first == stl_it->first);
+		REQUIRE(pending_rfm.begin() + k == pending_rfm.select(k));
+	}
+	for(size_t key = 0; key < 4010; key += 3) {
+		require_same_neighbours(const_rfm, stl_map, key);
+		require_same_neighbours(pending_rfm, stl_map, key);
+		REQUIRE(const_rfm.lower_bound_binary_search(key) == static_cast<size_t>(std::distance(stl_map.begin(), stl_map.lower_bound(key))));
+	}
+	std::vector<size_t> probes = {0, 17, 1999, 3998, 5000};
+	std::vector<Radix_Flat_Map<size_t, int>::iterator> found = pending_rfm.batch_find(probes);
+	for(size_t i = 0; i < probes.size(); i++) {
+		REQUIRE((found[i] == pending_rfm.end()) == (stl_map.count(probes[i]) == 0));
+	}
+	long long range_total = 0;
+	const_rfm.range_for_each(100, 900, [&range_total](size_t, int value) { range_total += value; });
+	long long expected_total = 0;
+	for(auto it = stl_map.lower_bound(100); it != stl_map.upper_bound(900); ++it) {
+		expected_total += it->second;
+	}
+	REQUIRE(range_total == expected_total);
+}
+
+TEST_CASE("Radix flat map batch lookups keep probe order", "[radix_sort][batch_lookup]") {
+	size_t N = 5000;
+	RandomDatasetGenerator rdg(N);
+
+	std::vector<std::pair<size_t, int>> batch;
+	for(size_t i = 0; i < N; i++) {
+		batch.emplace_back(rdg.random_size_ts[i] % 50000, static_cast<int>(i));
+	}
+	Radix_Flat_Map<size_t, int> rfm(batch.begin(), batch.end());
+
+	// Unsorted probes with repeats, hits, misses and both ends
+	std::vector<size_t> probes = {0, 50000, 49999};
+	for(size_t i = 0; i < N; i++) {
+		probes.push_back(i % 2 ? batch[i].first : rdg.random_size_ts[N - 1 - i] % 50001);
+	}
+	probes.push_back(probes[10]);
+
+	std::vector<Radix_Flat_Map<size_t, int>::iterator> found = rfm.batch_find(probes);
+	std::vector<Radix_Flat_Map<size_t, int>::iterator> predecessors = rfm.batch_predecessors(probes);
+	std::vector<Radix_Flat_Map<size_t, int>::iterator> successors = rfm.batch_successors(probes);
+	REQUIRE(found.size() == probes.size());
+	for(size_t i = 0; i < probes.size(); i++) {
+		REQUIRE(found[i] == rfm.find(probes[i]));
+		REQUIRE(predecessors[i] == rfm.predecessor(probes[i]));
+		REQUIRE(successors[i] == rfm.successor(probes[i]));
+	}
+
+	// Pending single-key writes are merged before the walk
+	rfm.insert(50001, 7);
+	REQUIRE(rfm.batch_find({50001})[0]->second == 7);
+	REQUIRE(rfm.batch_find({}).empty());
+}
+
+TEST_CASE("Radix flat map structure-of-arrays iterators", "[radix_sort][soa]") {
+	size_t N = 3000;
+	RandomDatasetGenerator rdg(N);
+
+	// Large values live in their own array, keys stay dense
+	std::vector<std::pair<size_t, std::array<int, 16>>> batch;
+	std::map<size_t, int> stl_map;
+	for(size_t i = 0; i < N; i++) {
+		std::array<int, 16> value{};
+		value[0] = rdg.random_ints[i];
+		batch.emplace_back(rdg.random_size_ts[i], value);
+		stl_map.emplace(rdg.random_size_ts[i], rdg.random_ints[i]);
+	}
+	Radix_Flat_Map<size_t, std::array<int, 16>> rfm(batch.begin(), batch.end());
+	REQUIRE(rfm.size() == stl_map.size());
+	REQUIRE(std::equal(rfm.begin(), rfm.end(), stl_map.begin(),
+		[](const auto& a, const auto& b) { return a.first == b.first and a.second[0] == b.second; }));
+
+	// Random access, writes through the proxy and const iteration
+	auto it = rfm.begin();
+	REQUIRE(rfm.end() - it == static_cast<std::ptrdiff_t>(rfm.size()));
+	REQUIRE((it + 5)->first == it[5].first);
+	REQUIRE((rfm.end() - 1)->first == stl_map.rbegin()->first);
+	it[3].second[1] = 42;
+	(it + 4)->second[1] = 43;
+	const auto& const_rfm = rfm;
+	Radix_Flat_Map<size_t, std::array<int, 16>>::const_iterator const_it = rfm.begin() + 3;
+	REQUIRE(const_it->second[1] == 42);
+	REQUIRE((++const_it)->second[1] == 43);
+	REQUIRE(const_it == rfm.begin() + 4);
+	REQUIRE(std::distance(const_rfm.begin(), const_rfm.end()) == static_cast<std::ptrdiff_t>(stl_map.size()));
+
+	std::pair<size_t, std::array<int, 16>> copied = *rfm.find(stl_map.begin()->first);
+	REQUIRE(copied.second[0] == stl_map.begin()->second);
+	REQUIRE(std::lower_bound(rfm.begin(), rfm.end(), stl_map.rbegin()->first,
+		[](const auto& p, size_t key) { return p.first < key; })->first == stl_map.rbegin()->first);
+
+	// bool values are real bools, not std::vector<bool> bits
+	Radix_Flat_Map<size_t, bool> flags;
+	flags[7] = true;
+	flags.insert(3, false);
+	bool& flag = flags[3];
+	flag = true;
+	REQUIRE(flags.size() == 2);
+	REQUIRE(flags.find(3)->second);
+	REQUIRE(flags.range_count(0, 10) == 2);
+	for(auto p : flags) {
+		p.second = false;
+	}
+	REQUIRE_FALSE(flags.find(7)->second);
+}
+
+TEST_CASE("Radix flat map SIMD block search", "[radix_sort][search]") {
+	size_t N = 64;
+	RandomDatasetGenerator rdg(N);
+
+	// Signed and unsigned keys on both sides of the sign bit
+	std::vector<int> ints, int_extremes = {std::numeric_limits<int>::min(), -1, 0, 1, std::numeric_limits<int>::max()};
+	std::vector<uint32_t> uints;
+	std::vector<int64_t> longs;
+	std::vector<size_t> size_ts;
+	std::vector<long long> long_longs;
+	std::vector<unsigned long long> unsigned_long_longs;
+	for(size_t i = 0; i < N; i++) {
+		ints.push_back(i < int_extremes.size() ? int_extremes[i] : rdg.random_ints[i] * (i % 2 ? -1 : 1));
+		uints.push_back(static_cast<uint32_t>(rdg.random_size_ts[i]) | (i % 2 ? 0x80000000u : 0));
+		longs.push_back(static_cast<int64_t>(rdg.random_size_ts[i]) * (i % 2 ? -1 : 1));
+		size_ts.push_back(rdg.random_size_ts[i] | (i % 2 ? size_t(1) << 63 : 0));
+		long_longs.push_back(static_cast<long long>(longs.back()));
+		unsigned_long_longs.push_back(static_cast<unsigned long long>(size_ts.back()));
+	}
+
+	// Every window size around FLAT_MAP_BLOCK_WINDOW, including partial vectors
+	auto check_block_search = [](const auto& probes) {
+		for(size_t size = 0; size <= 3 * FLAT_MAP_BLOCK_WINDOW; size++) {
+			auto keys = probes;
+			keys.resize(size);
+			std::sort(keys.begin(), keys.end());
+			keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+			for(const auto& probe : probes) {
+				REQUIRE(flat_map_lower_bound(probe, keys.data(), 0, keys.size()) ==
+					static_cast<size_t>(std::lower_bound(keys.begin(), keys.end(), probe) - keys.begin()));
+				REQUIRE(flat_map_upper_bound(probe, keys.data(), 0, keys.size()) ==
+					static_cast<size_t>(std::upper_bound(keys.begin(), keys.end(), probe) - keys.begin()));
+			}
+		}
+	};
+	check_block_search(ints);
+	check_block_search(uints);
+	check_block_search(longs);
+	check_block_search(size_ts);
+	check_block_search(long_longs);
+	check_block_search(unsigned_long_longs);
+	check_block_search(std::vector<char32_t>(uints.begin(), uints.end()));
+}
+
+TEST_CASE("Range queries match std::map on every map type", "[range]") {
+	size_t N = 3000;
+	RandomDatasetGenerator rdg(N);
+	std::map<int, long long> stl_map;
+	for(size_t i = 0; i < N; i++) {
+		stl_map.emplace(rdg.random_ints[i] / 4, static_cast<long long>(i % 1000));
+	}
+	std::vector<std::pair<int, long long>> pairs(stl_map.begin(), stl_map.end());
+
+	// Random, empty, inverted, single-key and whole-domain ranges
+	std::vector<std::pair<int, int>> ranges = {
+		{std::numeric_limits<int>::min(), std::numeric_limits<int>::max()}, {5, 4},
+		{pairs[10].first, pairs[10].first}, {pairs.back().first + 1, std::numeric_limits<int>::max()}};
+	for(size_t i = 0; i + 1 < N; i += 97) {
+		ranges.emplace_back(std::min(rdg.random_ints[i], rdg.random_ints[i + 1]), std::max(rdg.random_ints[i], rdg.random_ints[i + 1]));
+		ranges.emplace_back(rdg.random_ints[i] / 4, rdg.random_ints[i] / 4 + 1000000);
+	}
+
+	Radix_Flat_Map<int, long long> rfm(pairs.begin(), pairs.end());
+	XFastTrie<int, long long> xft(N);
+	AVL_Tree<int, long long> avl_tree;
+	Treap<int, long long> treap;
+	Batch_List<int, long long> batch_list;
+	for(const auto& p : pairs) {
+		xft.insert(p.first, p.second);
+		avl_tree.insert(p.first, p.second);
+		treap.insert(p.first, p.second);
+	}
+	batch_list.batch_insert(pairs.begin(), pairs.end());
+
+	auto check_range_queries = [&stl_map, &ranges](auto& map) {
+		for(const auto& range : ranges) {
+			std::vector<std::pair<int, long long>> expected, visited;
+			long long expected_sum = 0;
+			for(auto it = stl_map.lower_bound(range.first); range.first <= range.second and it != stl_map.end() and it->first <= range.second; ++it) {
+				expected.push_back(*it);
+				expected_sum += it->second;
+			}
+			map.range_for_each(range.first, range.second, [&visited](const int& key, const long long& value) { visited.emplace_back(key, value); });
+			REQUIRE(visited == expected);
+			REQUIRE(map.range_count(range.first, range.second) == expected.size());
+			REQUIRE(map.range_sum(range.first, range.second) == expected_sum);
+		}
+	};
+	check_range_queries(rfm);
+	check_range_queries(xft);
+	check_range_queries(avl_tree);
+	check_range_queries(treap);
+	check_range_queries(batch_list);
+
+	// range_count on the flat map counts pending single-key writes without merging them
+	for(size_t i = 0; i < 20; i++) {
+		rfm.insert(pairs[i].first + 1, 7);
+		stl_map.emplace(pairs[i].first + 1, 7);
+		rfm.erase(pairs[100 + i].first);
+		stl_map.erase(pairs[100 + i].first);
+	}
+	for(const auto& range : ranges) {
+		size_t expected_count = range.first > range.second ? 0 :
+			std::distance(stl_map.lower_bound(range.first), stl_map.upper_bound(range.second));
+		REQUIRE(rfm.range_count(range.first, range.second) == expected_count);
+	}
+	check_range_queries(rfm);
+}
+
+TEST_CASE("Order statistics: rank, select and range_count", "[order_statistics]") {
+	size_t N = 4000;
+	RandomDatasetGenerator rdg(N);
+	AVL_Tree<size_t, int, true> avl_tree;
+	Treap<size_t, int, true> treap;
+	Radix_Flat_Map<size_t, int> rfm;
+	std::map<size_t, int> stl_map;
+
+	// Inserts and erases interleaved so rotations run on both paths
+	for(size_t i = 0; i < N; i++) {
+		size_t key = rdg.random_size_ts[i] % 6000;
+		if(i % 3 == 2) {
+			REQUIRE(avl_tree.erase(key) == (stl_map.count(key) == 1));
+			REQUIRE(treap.erase(key) == (stl_map.count(key) == 1));
+			rfm.erase(key);
+			stl_map.erase(key);
+		}
+		else {
+			REQUIRE(avl_tree.insert(key, static_cast<int>(i)) == (stl_map.count(key) == 0));
+			REQUIRE(treap.insert(key, static_cast<int>(i)) == (stl_map.count(key) == 0));
+			rfm.insert(key, static_cast<int>(i));
+			stl_map.emplace(key, static_cast<int>(i));
+		}
+	}
+
+	std::vector<size_t> probes;
+	for(size_t i = 0; i < 500; i++) {
+		probes.push_back(rdg.random_size_ts[N - 1 - i] % 6100);
+	}
+
+	// The flat map answers rank from its pending writes before anything merges them
+	for(size_t probe : probes) {
+		REQUIRE(rfm.rank(probe) == static_cast<size_t>(std::distance(stl_map.begin(), stl_map.lower_bound(probe))));
+	}
+	auto check_order_statistics = [&stl_map, &probes](auto& map) {
+		REQUIRE(map.size() == stl_map.size());
+		size_t k = 0;
+		for(const auto& kv : stl_map) {
+			REQUIRE(map.select(k)->first == kv.first);
+			REQUIRE(map.rank(kv.first) == k);
+			k++;
+		}
+		REQUIRE(map.select(stl_map.size()) == map.end());
+		for(size_t i = 0; i + 1 < probes.size(); i++) {
+			size_t lo = std::min(probes[i], probes[i + 1]), hi = std::max(probes[i], probes[i + 1]);
+			REQUIRE(map.rank(probes[i]) == static_cast<size_t>(std::distance(stl_map.begin(), stl_map.lower_bound(probes[i]))));
+			REQUIRE(map.range_count(lo, hi) == static_cast<size_t>(std::distance(stl_map.lower_bound(lo), stl_map.upper_bound(hi))));
+			REQUIRE(map.range_count(hi, lo) == (lo == hi ? stl_map.count(lo) : 0));
+		}
+	};
+	check_order_statistics(avl_tree);
+	check_order_statistics(treap);
+	check_order_statistics(rfm);
+
+	// Unaugmented trees still answer range_count by walking the range
+	AVL_Tree<size_t, int> plain_avl;
+	Treap<size_t, int> plain_treap;
+	for(const auto& kv : stl_map) {
+		plain_avl.insert(kv.first, kv.second);
+		plain_treap.insert(kv.first, kv.second);
+	}
+	REQUIRE(plain_avl.range_count(100, 3000) == avl_tree.range_count(100, 3000));
+	REQUIRE(plain_treap.range_count(100, 3000) == treap.range_count(100, 3000));
+}
+
+TEST_CASE("Node pool allocator reuses freed nodes and releases in bulk", "[node_pool]") {
+	// Slabs double up to NODE_POOL_MAX_SLAB and freed slots are handed out again before new slabs
+	Node_Pool<std::pair<size_t, std::string>> pool;
+	std::vector<std::pair<size_t, std::string>*> nodes;
+	for(size_t i = 0; i < 1000; i++) {
+		nodes.push_back(pool.create(i, std::to_string(i)));
+	}
+	size_t slabs = pool.slab_count();
+	for(size_t i = 0; i < 1000; i += 2) {
+		pool.destroy(nodes[i]);
+	}
+	for(size_t i = 0; i < 1000; i += 2) {
+		nodes[i] = pool.create(i, "again");
+	}
+	REQUIRE(pool.slab_count() == slabs);
+	for(size_t i = 0; i < 1000; i++) {
+		REQUIRE(nodes[i]->first == i);
+		REQUIRE(nodes[i]->second == (i % 2 ? std::to_string(i) : "again"));
+		pool.destroy(nodes[i]);
+	}
+	pool.release();
+	REQUIRE(pool.slab_count() == 0);
+
+	// A moved-from pool is empty and never hands out slots of the slabs it gave away
+	Node_Pool<std::pair<size_t, std::string>> source;
+	std::vector<std::pair<size_t, std::string>*> moved_nodes;
+	for(size_t i = 0; i < 100; i++) {
+		moved_nodes.push_back(source.create(i, std::to_string(i)));
+	}
+	source.destroy(moved_nodes[7]);
+	Node_Pool<std::pair<size_t, std::string>> target(std::move(source));
+	REQUIRE(source.slab_count() == 0);
+	auto* fresh = source.create(1000, "fresh");
+	REQUIRE(moved_nodes[99]->second == "99");
+	REQUIRE(std::find(moved_nodes.begin(), moved_nodes.end(), fresh) == moved_nodes.end());
+	REQUIRE(target.create(7, "reused") == moved_nodes[7]);
+	for(auto* node : moved_nodes) target.destroy(node);
+	source.destroy(fresh);
+	target = std::move(source);
+	REQUIRE(source.slab_count() == 0);
+	REQUIRE(target.slab_count() == 1);
+	target.release();
+
+	// Containers behave the same on the pool and on plain new/delete, for trivial and non-trivial values
+	size_t N = 5000;
+	RandomDatasetGenerator rdg(N);
+	AVL_Tree<size_t, std::string> pooled_avl;
+	AVL_Tree<size_t, std::string, false, Heap_Node_Allocator> heap_avl;
+	Treap<size_t, int> pooled_treap;
+	Treap<size_t, int, false, Heap_Node_Allocator> heap_treap;
+	Doubly_Linked_List<size_t> pooled_list;
+	Doubly_Linked_List<size_t, Heap_Node_Allocator> heap_list;
+	std::map<size_t, int> stl_map;
+	for(size_t round = 0; round < 2; round++) {
+		for(size_t i = 0; i < N; i++) {
+			size_t key = rdg.random_size_ts[i] % 4000;
+			if(i % 4 == 3) {
+				REQUIRE(pooled_avl.erase(key) == heap_avl.erase(key));
+				REQUIRE(pooled_treap.erase(key) == heap_treap.erase(key));
+				REQUIRE(pooled_list.remove(key) == heap_list.remove(key));
+				stl_map.erase(key);
+			}
+			else {
+				REQUIRE(pooled_avl.insert(key, std::to_string(i)) == heap_avl.insert(key, std::to_string(i)));
+				REQUIRE(pooled_treap.insert(key, static_cast<int>(i)) == heap_treap.insert(key, static_cast<int>(i)));
+				pooled_list.addTail(key);
+				heap_list.addTail(key);
+				stl_map.emplace(key, static_cast<int>(i));
+			}
+		}
+		REQUIRE(pooled_avl.size() == stl_map.size());
+		REQUIRE(std::equal(pooled_avl.begin(), pooled_avl.end(), heap_avl.begin(),
+			[](const auto& a, const auto& b) { return a.first == b.first and a.second == b.second; }));
+		REQUIRE(std::equal(pooled_treap.begin(), pooled_treap.end(), stl_map.begin(),
+			[](const auto& a, const auto& b) { return a.first == b.first and a.second == b.second; }));
+		REQUIRE(pooled_list == Doubly_Linked_List<size_t>(pooled_list));
+		REQUIRE(std::equal(pooled_list.begin(), pooled_list.end(), heap_list.begin(), heap_list.end()));
+
+		// Cleared containers start over on fresh slabs
+		pooled_avl.clear();
+		heap_avl.clear();
+		pooled_treap.clear();
+		heap_treap.clear();
+		pooled_list.clear();
+		heap_list.clear();
+		stl_map.clear();
+		REQUIRE(pooled_avl.begin() == pooled_avl.end());
+		REQUIRE(pooled_list.empty());
+	}
+}
+
+TEST_CASE("Tree iterators follow parent links", "[iteration]") {
+	size_t N = 20000;
+	RandomDatasetGenerator rdg(N);
+	AVL_Tree<size_t, int> avl_tree;
+	Treap<size_t, int, true> treap;
+	std::map<size_t, int> stl_map;
+
+	// Erasing the extremes and two-child nodes moves data and relinks parents on every path
+	for(size_t i = 0; i < N; i++) {
+		size_t key = rdg.random_size_ts[i] % 8000;
+		if(i % 3 == 2 and !stl_map.empty()) {
+			size_t victim = i % 2 ? stl_map.begin()->first : (i % 5 ? key : stl_map.rbegin()->first);
+			REQUIRE(avl_tree.erase(victim) == (stl_map.count(victim) == 1));
+			REQUIRE(treap.erase(victim) == (stl_map.count(victim) == 1));
+			stl_map.erase(victim);
+		}
+		else {
+			avl_tree.insert(key, static_cast<int>(i));
+			treap.insert(key, static_cast<int>(i));
+			stl_map.emplace(key, static_cast<int>(i));
+		}
+	}
+	auto check_parent_linked_iteration = [&stl_map](auto& tree) {
+		REQUIRE(tree.size() == stl_map.size());
+		REQUIRE(std::equal(tree.begin(), tree.end(), stl_map.begin(), stl_map.end(),
+			[](const auto& a, const auto& b) { return a.first == b.first and a.second == b.second; }));
+
+		// Backwards from end() through the cached maximum
+		auto it = tree.end();
+		for(auto stl_it = stl_map.rbegin(); stl_it != stl_map.rend(); ++stl_it) {
+			--it;
+			REQUIRE(it->first == stl_it->first);
+		}
+		REQUIRE(it == tree.begin());
+
+		// Mid-tree steps in both directions
+		for(auto stl_it = stl_map.begin(); stl_it != stl_map.end(); std::advance(stl_it, std::min<size_t>(37, std::distance(stl_it, stl_map.end())))) {
+			auto tree_it = tree.find(stl_it->first);
+			if(stl_it != stl_map.begin()) REQUIRE(std::prev(tree_it)->first == std::prev(stl_it)->first);
+			if(std::next(stl_it) != stl_map.end()) REQUIRE(std::next(tree_it)->first == std::next(stl_it)->first);
+		}
+	};
+	check_parent_linked_iteration(avl_tree);
+	check_parent_linked_iteration(treap);
+	REQUIRE(treap.select(stl_map.size() / 2)->first == std::next(stl_map.begin(), stl_map.size() / 2)->first);
+
+	// Emptied trees iterate nothing and refill cleanly
+	for(const auto& kv : stl_map) {
+		avl_tree.erase(kv.first);
+		treap.erase(kv.first);
+	}
+	REQUIRE(avl_tree.begin() == avl_tree.end());
+	REQUIRE(treap.begin() == treap.end());
+	avl_tree.insert(5, 5);
+	treap.insert(5, 5);
+	REQUIRE((--avl_tree.end())->first == 5);
+	REQUIRE((--treap.end())->first == 5);
+}
+
+TEST_CASE("Batch list sorts only the inserts appended since the last read", "[batch_list][lazy_sort]") {
+	size_t N = 20000;
+	RandomDatasetGenerator rdg(N);
+	Batch_List<size_t, int> batch_list;
+	std::map<size_t, int> stl_map;
+
+	// Streaming single inserts with occasional reads; every read merges only what arrived since the last one
+	for(size_t i = 0; i < N; i++) {
+		size_t key = rdg.random_size_ts[i];
+		if(stl_map.emplace(key, static_cast<int>(i)).second) {
+			batch_list.insert(key, static_cast<int>(i));
+		}
+		if(i % 997 == 0) {
+			auto succ = batch_list.successor(key);
+			auto stl_succ = stl_map.upper_bound(key);
+			REQUIRE((succ == batch_list.end()) == (stl_succ == stl_map.end()));
+			if(stl_succ != stl_map.end()) REQUIRE(succ->first == stl_succ->first);
+		}
+	}
+	REQUIRE(batch_list.find(rdg.random_size_ts[N - 1]) != batch_list.end());
+	auto same_pair = [](const auto& a, const auto& b) { return a.first == b.first and a.second == b.second; };
+	REQUIRE(std::equal(batch_list.begin(), batch_list.end(), stl_map.begin(), stl_map.end(), same_pair));
+
+	// Appends above, below and between the sorted prefix
+	std::vector<std::pair<size_t, int>> batch = {{0, 1}, {std::numeric_limits<size_t>::max(), 2}, {stl_map.begin()->first + 1, 3}};
+	for(const auto& p : batch) {
+		if(stl_map.emplace(p).second) batch_list.insert(p);
+	}
+	// Const reads never merge: pending inserts must be sorted through the non-const API first
+	const Batch_List<size_t, int>& const_list = batch_list;
+	REQUIRE_THROWS_AS(const_list.begin(), std::logic_error);
+	batch_list.sort_keys();
+	REQUIRE(std::equal(const_list.begin(), const_list.end(), stl_map.begin(), stl_map.end(), same_pair));
+	REQUIRE(batch_list.predecessor(1)->first == 0);
+
+	batch_list.clear();
+	batch_list.insert(7, 7);
+	batch_list.insert(3, 3);
+	REQUIRE(batch_list.begin()->first == 3);
+	REQUIRE(batch_list.size() == 2);
+
+	// The inherited list mutators keep the unsorted tail counted
+	Batch_List<size_t, int> mutated;
+	mutated.insert(1, 1);
+	REQUIRE(mutated.removeTail());
+	mutated.insert(2, 2);
+	mutated.insert(0, 0);
+	REQUIRE(mutated.successor(0)->first == 2);
+	mutated.addHead({9, 9});
+	mutated.insertAt({5, 5}, 1);
+	mutated.addTail({4, 4});
+	REQUIRE(mutated.removeHead());
+	REQUIRE(mutated[0].first == 2);
+	mutated.insert(3, 3);
+	REQUIRE(mutated.removeAt(1));
+	mutated.insert(8, 8);
+	REQUIRE(mutated.remove({9, 9}));
+	mutated.insert(1, 1);
+	REQUIRE(mutated.removeNodesWithValue({5, 5}) == 1);
+	mutated.insert(6, 6);
+	REQUIRE(mutated.erase(mutated.find(2))->first == 4);
+	std::vector<size_t> expected_keys = {1, 4, 6, 8};
+	REQUIRE(std::equal(mutated.begin(), mutated.end(), expected_keys.begin(), expected_keys.end(),
+		[](const auto& a, size_t key) { return a.first == key; }));
+
+	// Copies merge pending inserts, so const lists never sort; batch_erase takes one pair per key in both lists
+	Unrolled_Batch_List<size_t, int> unrolled;
+	for(int i = 0; i < 3; i++) {
+		mutated.insert(4, 40 + i);
+		unrolled.insert(4, 40 + i);
+	}
+	unrolled.insert(1, 1);
+	const Batch_List<size_t, int> const_copy(mutated);
+	const Unrolled_Batch_List<size_t, int> const_unrolled(unrolled);
+	REQUIRE(std::is_sorted(const_copy.begin(), const_copy.end(), [](const auto& a, const auto& b) { return a.first < b.first; }));
+	REQUIRE(std::is_sorted(const_unrolled.begin(), const_unrolled.end(), [](const auto& a, const auto& b) { return a.first < b.first; }));
+	std::vector<size_t> erase_keys = {4, 4, 1};
+	mutated.batch_erase(erase_keys);
+	unrolled.batch_erase(erase_keys);
+	REQUIRE(mutated.size() == const_copy.size() - 2);
+	REQUIRE(unrolled.size() == const_unrolled.size() - 2);
+	REQUIRE(mutated.find(4)->second == 40);
+	REQUIRE(unrolled.find(4)->second == 41);
+	unrolled.insert(2, 2);
+	const Unrolled_Batch_List<size_t, int>& const_ref = unrolled;
+	REQUIRE_THROWS_AS(const_ref.begin(), std::logic_error);
+	unrolled.sort_keys();
+	REQUIRE(const_ref.begin()->first == 2);
+}
+
+TEST_CASE("Batch list express lane lookups and erase_key", "[batch_list][express_lane]") {
+	auto check_express_lane = [](auto batch_list, size_t stride, size_t N) {
+		RandomDatasetGenerator rdg(N);
+		std::map<size_t, int> stl_map;
+		std::vector<std::pair<size_t, int>> batch;
+		for(size_t i = 0; i < N; i++) {
+			size_t key = rdg.random_size_ts[i] % (4 * N);
+			if(stl_map.emplace(key, static_cast<int>(i)).second) batch.emplace_back(key, static_cast<int>(i));
+		}
+		batch_list.batch_insert(batch.begin(), batch.end());
+
+		// Point lookups and erases interleaved with single inserts, so the lane is patched and rebuilt
+		for(size_t i = 0; i < N; i++) {
+			size_t key = rdg.random_size_ts[N - 1 - i] % (4 * N);
+			require_same_neighbours(batch_list, stl_map, key);
+
+			if(i % 3 == 0) {
+				batch_list.erase_key(key);
+				stl_map.erase(key);
+			}
+			else if(i % 7 == 1 and stl_map.emplace(key + 1, 1).second) {
+				batch_list.insert(key + 1, 1);
+			}
+		}
+		REQUIRE(batch_list.size() == stl_map.size());
+		REQUIRE(std::equal(batch_list.begin(), batch_list.end(), stl_map.begin(), stl_map.end(),
+			[](const auto& a, const auto& b) { return a.first == b.first and a.second == b.second; }));
+
+		// erase_key removes every copy of a repeated key, including runs across lane entries
+		decltype(batch_list) copy(batch_list);
+		size_t repeated = stl_map.begin()->first;
+		for(size_t i = 0; i < 3 * stride + 5; i++) copy.insert(repeated, 0);
+		REQUIRE(copy.find(repeated) != copy.end());
+		copy.erase_key(repeated);
+		REQUIRE(copy.find(repeated) == copy.end());
+		REQUIRE(copy.size() == stl_map.size() - 1);
+		REQUIRE(copy.successor(repeated) == copy.begin());
+		REQUIRE(batch_list.find(repeated) != batch_list.end());
+
+		// Every node-removing path patches the lane, so lookups never start from a destroyed node
+		std::vector<size_t> keys;
+		for(const auto& p : stl_map) keys.push_back(p.first);
+		for(size_t i = 0; i < keys.size(); i++) {
+			size_t key = keys[i];
+			if(i % 4 == 0) {
+				batch_list.erase(batch_list.find(key));
+				stl_map.erase(key);
+			}
+			else if(i % 4 == 1 and batch_list.removeHead()) {
+				stl_map.erase(stl_map.begin());
+			}
+			else if(i % 4 == 2 and batch_list.removeTail()) {
+				stl_map.erase(std::prev(stl_map.end()));
+			}
+			require_same_neighbours(batch_list, stl_map, key);
+			if(stl_map.empty()) break;
+		}
+		REQUIRE(batch_list.size() == stl_map.size());
+	};
+	check_express_lane(Batch_List<size_t, int>(), BATCH_LIST_EXPRESS_STRIDE, 5000);
+	check_express_lane(Batch_List<size_t, int, 4>(), 4, 3000);
+	check_express_lane(Batch_List<size_t, int, 0>(), 0, 2000);
+	check_express_lane(Batch_List<size_t, int, 1>(), 1, 300);
+}
+
+TEST_CASE("Unrolled batch list matches std::map and Batch_List", "[batch_list][unrolled]") {
+	auto check_unrolled = [](auto unrolled, size_t chunk_capacity, size_t N) {
+		RandomDatasetGenerator rdg(N);
+		std::map<size_t, int> stl_map;
+		std::vector<std::pair<size_t, int>> batch;
+		for(size_t i = 0; i < N; i++) {
+			size_t key = rdg.random_size_ts[i] % (4 * N);
+			if(stl_map.emplace(key, static_cast<int>(i)).second) batch.emplace_back(key, static_cast<int>(i));
+		}
+		unrolled.batch_insert(batch.begin(), batch.end());
+		auto same_pair = [](const auto& a, const auto& b) { return a.first == b.first and a.second == b.second; };
+		REQUIRE(std::equal(unrolled.begin(), unrolled.end(), stl_map.begin(), stl_map.end(), same_pair));
+
+		// Single inserts split chunks, erases merge and borrow; every answer is checked against std::map
+		for(size_t i = 0; i < N; i++) {
+			size_t key = rdg.random_size_ts[N - 1 - i] % (4 * N);
+			require_same_neighbours(unrolled, stl_map, key);
+
+			if(i % 2 == 0) {
+				unrolled.erase_key(key);
+				stl_map.erase(key);
+			}
+			else if(stl_map.emplace(key + 1, 1).second) {
+				unrolled.insert(key + 1, 1);
+			}
+		}
+		REQUIRE(unrolled.size() == stl_map.size());
+		REQUIRE(std::equal(unrolled.begin(), unrolled.end(), stl_map.begin(), stl_map.end(), same_pair));
+		// Every chunk but the last stays at least a quarter full
+		REQUIRE(unrolled.chunk_count() <= stl_map.size() / (chunk_capacity / 4) + 1);
+
+		// Batch sweeps and range queries agree with Batch_List and std::map
+		Batch_List<size_t, int> batch_list;
+		batch_list.batch_insert(stl_map.begin(), stl_map.end());
+		std::vector<size_t> probes;
+		for(size_t i = 0; i < N; i += 3) probes.push_back(rdg.random_size_ts[i] % (4 * N));
+		auto unrolled_found = unrolled.batch_find(probes);
+		auto list_found = batch_list.batch_find(probes);
+		auto unrolled_preds = unrolled.batch_predecessors(probes);
+		auto list_preds = batch_list.batch_predecessors(probes);
+		auto unrolled_succs = unrolled.batch_successors(probes);
+		auto list_succs = batch_list.batch_successors(probes);
+		for(size_t i = 0; i < probes.size(); i++) {
+			REQUIRE((unrolled_found[i] == unrolled.end()) == (list_found[i] == batch_list.end()));
+			REQUIRE((unrolled_preds[i] == unrolled.end()) == (list_preds[i] == batch_list.end()));
+			if(list_preds[i] != batch_list.end()) REQUIRE(unrolled_preds[i]->first == list_preds[i]->first);
+			REQUIRE((unrolled_succs[i] == unrolled.end()) == (list_succs[i] == batch_list.end()));
+			if(list_succs[i] != batch_list.end()) REQUIRE(unrolled_succs[i]->first == list_succs[i]->first);
+		}
+		for(size_t i = 0; i + 1 < probes.size(); i += 2) {
+			size_t lo = std::min(probes[i], probes[i + 1]);
+			size_t hi = std::max(probes[i], probes[i + 1]);
+			REQUIRE(unrolled.range_count(lo, hi) == batch_list.range_count(lo, hi));
+			REQUIRE(unrolled.range_sum(lo, hi) == batch_list.range_sum(lo, hi));
+		}
+
+		unrolled.batch_erase(probes);
+		for(size_t key : probes) stl_map.erase(key);
+		const decltype(unrolled) copy(unrolled);
+		REQUIRE(copy.size() == stl_map.size());
+		REQUIRE(std::equal(copy.begin(), copy.end(), stl_map.begin(), stl_map.end(), same_pair));
+		REQUIRE(unrolled.chunk_count() <= stl_map.size() / (chunk_capacity / 4) + 1);
+
+		// Repeated keys stay in insertion order and erase_key removes the whole run
+		size_t repeated = stl_map.begin()->first;
+		for(int i = 0; i < static_cast<int>(3 * chunk_capacity); i++) unrolled.insert(repeated, i);
+		auto run = unrolled.find(repeated);
+		++run;
+		for(int i = 0; i < static_cast<int>(3 * chunk_capacity); i++, ++run) REQUIRE(run->second == i);
+		unrolled.erase_key(repeated);
+		REQUIRE(unrolled.find(repeated) == unrolled.end());
+		REQUIRE(unrolled.size() == stl_map.size() - 1);
+
+		unrolled.clear();
+		REQUIRE(unrolled.begin() == unrolled.end());
+		REQUIRE(unrolled.chunk_count() == 0);
+	};
+	check_unrolled(Unrolled_Batch_List<size_t, int>(), UNROLLED_CHUNK_CAPACITY, 5000);
+	check_unrolled(Unrolled_Batch_List<size_t, int, 16>(), 16, 3000);
+	check_unrolled(Unrolled_Batch_List<size_t, int, 64>(), 64, 3000);
+	check_unrolled(Unrolled_Batch_List<size_t, int, 4>(), 4, 500);
+}
+
+TEST_CASE("Batch insert merge-joins into the sorted list, one node per key", "[batch_list][batch_insert]") {
+	auto check_merge_join = [](auto list, size_t N) {
+		RandomDatasetGenerator rdg(N);
+		std::map<size_t, int> stl_map;
+		std::vector<std::pair<size_t, int>> batch;
+		for(size_t i = 0; i < N / 2; i++) {
+			size_t key = rdg.random_size_ts[i] % N;
+			batch.emplace_back(key, static_cast<int>(i));
+			stl_map.emplace(key, static_cast<int>(i));
+		}
+		list.batch_insert(batch.begin(), batch.end());
+		REQUIRE(list.size() == stl_map.size());
+
+		// The second batch overlaps the list and repeats its own keys: the list's value wins, then the first repeat
+		batch.clear();
+		for(size_t i = N / 2; i < N; i++) {
+			size_t key = rdg.random_size_ts[i] % N;
+			batch.emplace_back(key, static_cast<int>(i));
+			batch.emplace_back(key, -1);
+			stl_map.emplace(key, static_cast<int>(i));
+		}
+		batch.emplace_back(0, -2);
+		batch.emplace_back(N, -3);
+		stl_map.emplace(0, -2);
+		stl_map.emplace(N, -3);
+		list.batch_insert(batch.begin(), batch.end());
+		REQUIRE(list.size() == stl_map.size());
+		REQUIRE(std::equal(list.begin(), list.end(), stl_map.begin(), stl_map.end(),
+			[](const auto& a, const auto& b) { return a.first == b.first and a.second == b.second; }));
+
+		std::vector<size_t> probes;
+		for(size_t i = 0; i < N; i++) probes.push_back(rdg.random_size_ts[i] % N);
+		for(auto found : list.batch_find(probes)) {
+			REQUIRE(found != list.end());
+			REQUIRE(found->second == stl_map[found->first]);
+		}
+
+		std::vector<std::pair<size_t, int>> empty_batch;
+		list.batch_insert(empty_batch.begin(), empty_batch.end());
+		REQUIRE(list.size() == stl_map.size());
+	};
+	check_merge_join(Batch_List<size_t, int>(), 5000);
+	check_merge_join(Batch_List<size_t, int, 0>(), 1000);
+	check_merge_join(Unrolled_Batch_List<size_t, int>(), 5000);
+	check_merge_join(Unrolled_Batch_List<size_t, int, 4>(), 1000);
+}
+
+TEST_CASE("Batch N Hash List sorts only the keys inserted since the last sort", "[sorting][incremental]") {
+	size_t N = 4000;
+	RandomDatasetGenerator rdg(N);
+	Batch_N_Hash_List<size_t, int> bnhl(N);
+	std::map<size_t, int> stl_map;
+	auto same_order = [&]() {
+		bnhl.sort_keys();
+		REQUIRE(bnhl.size() == stl_map.size());
+		auto iter = bnhl.begin();
+		for(auto stl_iter = stl_map.begin(); stl_iter != stl_map.end(); ++stl_iter, ++iter) {
+			REQUIRE(iter.key() == stl_iter->first);
+		}
+		REQUIRE(iter == bnhl.end());
+	};
+
+	// Every kind of insert lands somewhere arbitrary, removals and re-inserts of pending and sorted keys
+	for(size_t i = 0; i < N; i++) {
+		size_t key = rdg.random_size_ts[i] % (2 * N);
+		if(stl_map.count(key) == 1) {
+			REQUIRE(bnhl.remove(key));
+			stl_map.erase(key);
+		}
+		else {
+			if(i % 4 == 0 or bnhl.empty()) bnhl.addHead(key, static_cast<int>(i));
+			else if(i % 4 == 1) bnhl.addTail(key, static_cast<int>(i));
+			else if(i % 4 == 2) bnhl.insertAt(key, static_cast<int>(i), bnhl.size() / 2);
+			else bnhl.insertAfter(key, static_cast<int>(i), bnhl.getHead());
+			stl_map.emplace(key, static_cast<int>(i));
+		}
+		if(i % 101 == 0) {
+			auto succ = bnhl.successor(key);
+			auto stl_succ = stl_map.upper_bound(key);
+			REQUIRE((succ == bnhl.end()) == (stl_succ == stl_map.end()));
+			if(stl_succ != stl_map.end()) REQUIRE(succ.key() == stl_succ->first);
+		}
+		if(i % 997 == 0) same_order();
+	}
+	same_order();
+
+	// A clean list keeps its order, a repeated addHead of a present key records nothing
+	bnhl.addHead(stl_map.begin()->first, -1);
+	same_order();
+	bnhl.clear();
+	stl_map.clear();
+	bnhl.addTail(9, 9);
+	bnhl.addTail(3, 3);
+	stl_map.emplace(9, 9);
+	stl_map.emplace(3, 3);
+	same_order();
+}